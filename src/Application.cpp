@@ -10,8 +10,8 @@
  */
 #include "Application.h"
 
-Application::Application(std::vector<std::string> inputDirectories)
-        : inputDirectories(std::move(inputDirectories)) {}
+Application::Application(std::vector<std::string> inputDirectories, int maxWalkingDuration)
+        : inputDirectories(std::move(inputDirectories)), maxWalkingDuration(maxWalkingDuration) {}
 
 void Application::run() {
 
@@ -28,6 +28,12 @@ void Application::run() {
 
     if (command == "query") {
       handleQuery();
+    } else if (command == "profile") {
+      handleProfileQuery();
+    } else if (command == "criteria") {
+      handleMultiCriteriaQuery();
+    } else if (command == "all") {
+      handleAllQuery();
     } else if (command == "help") {
       showCommands();
     } else if (command == "quit") {
@@ -39,46 +45,85 @@ void Application::run() {
     }
   }
 }
-void Application::initializeRaptor(){
-  std::unordered_map<std::string, Agency> agencies;
-  std::unordered_map<std::string, Calendar> calendars;
-  std::unordered_map<std::string, Trip> trips;
-  std::unordered_map<std::pair<std::string, std::string>, Route, pair_hash> routes;
-  std::unordered_map<std::string, Stop> stops;
-  std::unordered_map<std::pair<std::string, std::string>, StopTime, pair_hash> stop_times;
+void Application::compile(const std::string &output) {
+  initializeRaptor();
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  raptor_->getTimetable().save(output);
+  auto end_time = std::chrono::high_resolution_clock::now();
+
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+  std::cout << "Timetable snapshot written to " << output << " in " << duration << " ms." << std::endl;
+}
+
+void Application::verify() {
+  if (inputDirectories.size() != 1 || !std::filesystem::is_regular_file(inputDirectories.front()))
+    throw std::runtime_error("Only a timetable snapshot can be verified.");
+
+  initializeRaptor();
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  raptor_->getTimetable().verify();
+  auto end_time = std::chrono::high_resolution_clock::now();
 
-  for (const auto &dir: inputDirectories) {
-    Parser parser(dir);
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
 
-    auto dirAgencies = parser.getAgencies();
-    agencies.insert(dirAgencies.begin(), dirAgencies.end());
+  std::cout << "Timetable snapshot checksum verified in " << duration << " ms." << std::endl;
+}
 
-    auto dirCalendars = parser.getCalendars();
-    calendars.insert(dirCalendars.begin(), dirCalendars.end());
+void Application::serve(const std::string &address, size_t numWorkers) {
+  initializeRaptor();
+
+  Server server(*raptor_, numWorkers > 0 ? numWorkers : std::max(1u, std::thread::hardware_concurrency()));
+  server.listen(address);
+}
+
+void Application::batch(const std::string &queries, const std::string &output, size_t numWorkers) {
+  initializeRaptor();
 
-    auto dirTrips = parser.getTrips();
-    trips.insert(dirTrips.begin(), dirTrips.end());
+  BatchRunner runner(*raptor_, numWorkers > 0 ? numWorkers : std::max(1u, std::thread::hardware_concurrency()));
+  runner.run(queries, output);
+}
 
-    auto dirRoutes = parser.getRoutes();
-    routes.insert(dirRoutes.begin(), dirRoutes.end());
+void Application::initializeRaptor(){
+  if (inputDirectories.size() == 1 && std::filesystem::is_regular_file(inputDirectories.front())) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    raptor_ = Raptor(Timetable::load(inputDirectories.front()));
+    auto end_time = std::chrono::high_resolution_clock::now();
 
-    auto dirStops = parser.getStops();
-    stops.insert(dirStops.begin(), dirStops.end());
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
 
-    auto dirStopTimes = parser.getStopTimes();
-    stop_times.insert(dirStopTimes.begin(), dirStopTimes.end());
+    std::cout << "Timetable snapshot loaded in " << duration << " ms." << std::endl;
+    return;
   }
 
-  raptor_ = Raptor(agencies, calendars, stops, routes, trips, stop_times);
+  // Parse the directories concurrently, and merge them in order
+  // The parsers share the feed's interner, so that merging does not intern the IDs again
+  ThreadPool pool;
+  GTFSFeed feed;
+  std::vector<std::future<std::unique_ptr<Parser>>> parsers;
+  for (const auto &dir: inputDirectories)
+    parsers.push_back(pool.submit([dir, &pool, strings = feed.strings]() {
+      return std::make_unique<Parser>(dir, &pool, strings);
+    }));
+
+  for (auto &future: parsers)
+    feed.merge(pool.wait(future)->getFeed(), &pool);
+
+  raptor_ = Raptor(feed, maxWalkingDuration);
 }
 
 void Application::showCommands() {
   std::cout << std::endl << "Available commands:" << std::endl;
 
   std::cout << std::left << std::setw(30) << " 1. query " << " Runs RAPTOR algorithm." << std::endl;
-  std::cout << std::left << std::setw(30) << " 2. help " << " Shows available commands. " << std::endl;
+  std::cout << std::left << std::setw(30) << " 2. profile " << " Runs RAPTOR over a departure window. " << std::endl;
+  std::cout << std::left << std::setw(30) << " 3. criteria " << " Runs McRAPTOR with extra criteria. " << std::endl;
+  std::cout << std::left << std::setw(30) << " 4. all " << " Runs RAPTOR from a stop to every stop. " << std::endl;
+  std::cout << std::left << std::setw(30) << " 5. help " << " Shows available commands. " << std::endl;
 
-  std::cout << " 3. quit " << std::endl;
+  std::cout << " 6. quit " << std::endl;
 }
 
 void Application::handleQuery() {
@@ -94,6 +139,91 @@ void Application::handleQuery() {
   std::cout << "Took " << duration << " ms (" << std::round(static_cast<double>(duration) / 1000.0) << " seconds) to look for journeys."
             << std::endl;
 
+  showJourneys(journeys);
+}
+
+void Application::handleProfileQuery() {
+  Query query = getQuery();
+
+  while (true) {
+    std::cout << "Latest departure time:" << std::endl;
+    query.latest_departure_time = getDepartureTime();
+
+    if (Utils::timeToSeconds(query.latest_departure_time.value()) >= Utils::timeToSeconds(query.departure_time))
+      break;
+    std::cout << "Invalid latest departure time. Please enter a time not before the departure time." << std::endl;
+  }
+
+  raptor_->setQuery(query);
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  std::vector<Journey> journeys = raptor_->findProfileJourneys();
+  auto end_time = std::chrono::high_resolution_clock::now();
+
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+  std::cout << "Took " << duration << " ms (" << std::round(static_cast<double>(duration) / 1000.0) << " seconds) to look for journeys."
+            << std::endl;
+
+  showJourneys(journeys);
+}
+
+void Application::handleMultiCriteriaQuery() {
+  Query query = getQuery();
+  query.criteria = getCriteria();
+  raptor_->setQuery(query);
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  std::vector<Journey> journeys = raptor_->findMultiCriteriaJourneys();
+  auto end_time = std::chrono::high_resolution_clock::now();
+
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+  std::cout << "Took " << duration << " ms (" << std::round(static_cast<double>(duration) / 1000.0) << " seconds) to look for journeys."
+            << std::endl;
+
+  showJourneys(journeys);
+}
+
+void Application::handleAllQuery() {
+  std::string source = getSource();
+  Date date = getDate();
+  Time departure_time = getDepartureTime();
+
+  raptor_->setQuery({source, "", date, departure_time});
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  RoundArrivals arrivals = raptor_->findAllArrivals();
+  auto end_time = std::chrono::high_resolution_clock::now();
+
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+  std::cout << "Took " << duration << " ms (" << std::round(static_cast<double>(duration) / 1000.0) << " seconds) to look for arrivals."
+            << std::endl;
+
+  const Timetable &timetable = raptor_->getTimetable();
+  std::cout << std::endl << std::setw(8) << "stop " << std::setw(14) << "(name)"
+            << std::setw(10) << "arr_time " << std::setw(8) << "trips" << std::endl;
+
+  // Each reachable stop, with its earliest arrival and the fewest trips that reach it then
+  size_t reached = 0;
+  for (StopId stop_id = 0; stop_id < timetable.numStops(); ++stop_id) {
+    std::optional<int> arrival = arrivals.back()[stop_id];
+    if (!arrival.has_value()) continue;
+
+    size_t trips = 0;
+    while (arrivals[trips][stop_id] != arrival) trips++;
+
+    std::cout << std::setw(8) << timetable.getStopId(stop_id)
+              << std::setw(14) << Utils::getFirstWord(std::string(timetable.getStopName(stop_id)))
+              << std::setw(10) << Utils::secondsToTime(arrival) << std::setw(8) << trips << std::endl;
+    reached++;
+  }
+
+  std::cout << std::endl << "Reached " << reached << " of " << timetable.numStops() << " stops." << std::endl;
+}
+
+void Application::showJourneys(const std::vector<Journey> &journeys) const {
   if (journeys.empty()) std::cout << "No journey found :/" << std::endl;
   else {
     std::cout << "Found " << journeys.size() << " journey(s)! =) " << std::endl;
@@ -102,7 +232,7 @@ void Application::handleQuery() {
       int journey_duration = journey.duration;
       std::cout << std::endl << "Journey " << i + 1 << " (" << Utils::secondsToTime(journey_duration) << "): "
                 << std::endl << std::endl;
-      Raptor::showJourney(journey);
+      raptor_->showJourney(journey);
     }
   }
 }
@@ -123,7 +253,7 @@ std::string Application::getSource() {
     std::getline(std::cin, source);
     Utils::clean(source);
 
-    if (raptor_->getStops().find(source) != raptor_->getStops().end())
+    if (raptor_->getTimetable().findStop(source).has_value())
       break;
     else
       std::cout << "Invalid source stop id. Please try again. Example: 5753 for Metro or SAL2 for STCP." << std::endl;
@@ -139,7 +269,7 @@ std::string Application::getTarget() {
     std::getline(std::cin, target);
     Utils::clean(target);
 
-    if (raptor_->getStops().find(target) != raptor_->getStops().end())
+    if (raptor_->getTimetable().findStop(target).has_value())
       break;
     else
       std::cout << "Invalid target stop id. Please try again. Example: 5753 for Metro or SAL2 for STCP." << std::endl;
@@ -153,13 +283,7 @@ Date Application::getDate(){
   int month = getMonth();
   int day = getDay(year, month);
 
-  std::tm time_info = {};
-  time_info.tm_year = year - 1900;
-  time_info.tm_mon = month - 1;
-  time_info.tm_mday = day;
-  std::mktime(&time_info);
-
-  return {year, month, day, time_info.tm_wday};
+  return {year, month, day, Utils::getWeekday(year, month, day)};
 }
 
 int Application::getYear() {
@@ -251,3 +375,19 @@ int Application::getMinutes() {
   }
   return minutes;
 }
+
+std::vector<Criterion> Application::getCriteria() {
+  std::string input;
+  while (true) {
+    std::cout << "Criteria (walking, agencies, zones, separated by commas): ";
+    std::getline(std::cin, input);
+    Utils::clean(input);
+    input.erase(std::remove(input.begin(), input.end(), ' '), input.end());
+
+    try {
+      return Utils::parseCriteria(input);
+    } catch (const std::runtime_error &e) {
+      std::cout << e.what() << " Please try again. Example: walking,agencies" << std::endl;
+    }
+  }
+}
@@ -12,8 +12,11 @@
 #define RAPTOR_APPLICATION_H
 
 #include "Raptor.h"
+#include "Server.h"
+#include "BatchRunner.h"
 #include <iostream>
 #include <iomanip>
+#include <filesystem>
 
 /**
  * @class Application
@@ -27,20 +30,52 @@ public:
   /**
    * @brief Constructs an Application instance with the given input directories.
    * @param inputDirectories A vector of directories containing transit data files.
+   * @param maxWalkingDuration The longest footpath to generate between stops, in seconds.
    */
-  explicit Application(std::vector<std::string> inputDirectories);
+  explicit Application(std::vector<std::string> inputDirectories,
+                       int maxWalkingDuration = DEFAULT_MAX_WALKING_DURATION);
 
   /**
    * @brief Starts the application, providing a command-line interface for users.
    */
   void run();
 
+  /**
+   * @brief Compiles the input directories into a binary timetable snapshot.
+   * @param output Path of the snapshot file to write.
+   */
+  void compile(const std::string &output);
+
+  /**
+   * @brief Loads the timetable snapshot given as the only input, and checks the checksum of all of it.
+   * @throws std::runtime_error If the input is not a snapshot, or its checksum does not match.
+   */
+  void verify();
+
+  /**
+   * @brief Answers queries received over a local socket, until the process is terminated.
+   * @param address A port to listen on at 127.0.0.1, or the path of a Unix socket.
+   * @param numWorkers The number of queries answered at once, or 0 for one per hardware thread.
+   */
+  void serve(const std::string &address, size_t numWorkers);
+
+  /**
+   * @brief Answers the queries of a CSV file into a JSON lines file.
+   * @param queries Path of the CSV file of queries.
+   * @param output Path of the JSON lines file to write.
+   * @param numWorkers The number of queries answered at once, or 0 for one per hardware thread.
+   */
+  void batch(const std::string &queries, const std::string &output, size_t numWorkers);
+
 private:
   std::vector<std::string> inputDirectories;  ///< Directories containing transit data files.
+  int maxWalkingDuration;                     ///< Longest footpath generated between stops, in seconds.
   std::optional<Raptor> raptor_;              ///< Optional instance of the RAPTOR algorithm.
 
   /**
    * @brief Initializes the RAPTOR data structures by parsing input files.
+   *
+   * If the only input is a regular file, it is memory-mapped as a timetable snapshot instead.
    */
   void initializeRaptor();
 
@@ -54,6 +89,27 @@ private:
    */
   void handleQuery();
 
+  /**
+   * @brief Handles a profile query, finding the journeys departing within a time window.
+   */
+  void handleProfileQuery();
+
+  /**
+   * @brief Handles a multi-criteria query, finding the journeys that are Pareto-optimal under chosen criteria.
+   */
+  void handleMultiCriteriaQuery();
+
+  /**
+   * @brief Handles a one-to-all query, displaying the earliest arrival at every reachable stop.
+   */
+  void handleAllQuery();
+
+  /**
+   * @brief Displays the journeys found for a query.
+   * @param journeys The journeys to display.
+   */
+  void showJourneys(const std::vector<Journey> &journeys) const;
+
   /**
    * @brief Retrieves a query from the user, including source, target, date, and time.
    * @return A Query object representing the user's transit request.
@@ -115,6 +171,12 @@ private:
    * @return The entered minutes as an integer.
    */
   static int getMinutes();
+
+  /**
+   * @brief Prompts the user to enter the criteria of a multi-criteria query.
+   * @return The criteria, besides arrival time and number of trips.
+   */
+  static std::vector<Criterion> getCriteria();
 };
 
 #endif //RAPTOR_APPLICATION_H
@@ -0,0 +1,111 @@
+/**
+ * @file BatchRunner.cpp
+ * @brief BatchRunner class implementation
+ *
+ * This file contains the implementation of the BatchRunner class, which reads queries
+ * from a CSV file and answers them on a pool of workers into a JSON lines file.
+ */
+
+#include "BatchRunner.h"
+
+#include <fstream>
+#include <chrono>
+
+#include "CsvReader.h"
+
+/**
+ * @brief Strips the spaces around a field.
+ * @param[in] field The field.
+ * @return The field, without leading nor trailing spaces.
+ */
+static std::string_view strip(std::string_view field) {
+  size_t start = field.find_first_not_of(" \t\r");
+  if (start == std::string_view::npos) return {};
+  return field.substr(start, field.find_last_not_of(" \t\r") - start + 1);
+}
+
+BatchRunner::BatchRunner(const Raptor &raptor, size_t num_workers) : raptor_(raptor), pool_(num_workers) {}
+
+void BatchRunner::run(const std::string &queries_path, const std::string &output_path) {
+  CsvReader reader(queries_path);
+
+  auto required = [&](std::string_view name) {
+    std::optional<size_t> column = reader.findColumn(name);
+    if (!column.has_value())
+      throw std::runtime_error("Missing column " + std::string(name) + " in " + queries_path);
+    return column.value();
+  };
+
+  Columns columns{reader.findColumn("id"), required("source"), reader.findColumn("target"),
+                  required("date"), required("time"), reader.findColumn("latest_time"),
+                  reader.findColumn("criteria")};
+
+  std::ofstream output(output_path, std::ios::binary);
+  if (!output) throw std::runtime_error("Could not open " + output_path + " for writing.");
+
+  std::vector<std::string_view> row;
+  std::vector<QueryRequest> requests;
+  std::vector<std::string> responses;
+  size_t num_queries = 0, num_errors = 0;
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+
+  while (true) {
+    requests.clear();
+    while (requests.size() < BLOCK_SIZE && reader.readRow(row))
+      requests.push_back(readRequest(row, columns, num_queries + requests.size() + 1));
+
+    if (requests.empty()) break;
+
+    responses.assign(requests.size(), std::string());
+    pool_.parallelFor(requests.size(), [this, &requests, &responses](size_t i) {
+      auto started = std::chrono::steady_clock::now();
+      responses[i] = requests[i].answer(raptor_);
+      auto finished = std::chrono::steady_clock::now();
+
+      QueryRequest::addField(responses[i], "latency_us",
+                             std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(
+                                 finished - started).count()));
+    });
+
+    for (const std::string &response: responses) {
+      if (response.find(",\"error\":") != std::string::npos) ++num_errors;
+      output << response << '\n';
+    }
+
+    num_queries += requests.size();
+    std::cout << "Answered " << num_queries << " queries..." << std::endl;
+  }
+
+  output.flush();
+  if (!output) throw std::runtime_error("Could not write to " + output_path);
+
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+  std::cout << "Answered " << num_queries << " queries (" << num_errors << " invalid) in " << duration
+            << " ms with " << pool_.size() << " worker(s)." << std::endl;
+}
+
+QueryRequest BatchRunner::readRequest(const std::vector<std::string_view> &row, const Columns &columns,
+                                      size_t number) {
+  auto field = [&row](std::optional<size_t> column) {
+    return column.has_value() && column.value() < row.size() ? std::string(strip(row[column.value()]))
+                                                              : std::string();
+  };
+
+  QueryRequest request;
+  request.id = columns.id.has_value() ? QueryRequest::quote(field(columns.id)) : std::to_string(number);
+  request.source = field(columns.source);
+  request.target = field(columns.target);
+  request.date = field(columns.date);
+  request.time = field(columns.time);
+
+  std::string latest_time = field(columns.latest_time);
+  if (!latest_time.empty()) request.latest_time = latest_time;
+
+  std::string criteria = field(columns.criteria);
+  if (!criteria.empty()) request.criteria = criteria;
+
+  return request;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file BatchRunner.h
+ * @brief Defines the BatchRunner class, which answers a file of RAPTOR queries in parallel.
+ *
+ * This header file declares the BatchRunner class. Queries are read from a CSV file, answered
+ * by a pool of workers, each reusing its own QueryContext, and written as JSON lines in input order,
+ * in the same format as the responses of the query server.
+ */
+
+#ifndef RAPTOR_BATCHRUNNER_H
+#define RAPTOR_BATCHRUNNER_H
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <string_view>
+
+#include "Raptor.h"
+#include "QueryRequest.h"
+#include "ThreadPool.h"
+
+/**
+ * @class BatchRunner
+ * @brief Answers the queries of a CSV file into a JSON lines file.
+ *
+ * The CSV file has the columns `source`, `date` (YYYYMMDD) and `time` (HH:MM:SS), and optionally
+ * `target`, `latest_time`, `criteria` and `id`. Rows without a target get the earliest arrival at every reachable
+ * stop, rows with a latest time the journeys of a profile query, and rows with criteria (e.g. `"walking,agencies"`)
+ * the journeys of a multi-criteria query. Without an `id` column, responses are identified
+ * by the row number, starting at 1. Every response reports how long its query took (`latency_us`).
+ *
+ * Rows are read, answered and written in blocks, so that memory stays bounded however long the file is.
+ */
+class BatchRunner {
+public:
+  static constexpr size_t BLOCK_SIZE = 1024; ///< Queries read and answered at once.
+
+  /**
+   * @brief Starts the workers.
+   *
+   * @param[in] raptor The router answering the queries. Must outlive the runner.
+   * @param[in] num_workers The number of workers. Defaults to the number of hardware threads.
+   */
+  explicit BatchRunner(const Raptor &raptor, size_t num_workers = std::max(1u, std::thread::hardware_concurrency()));
+
+  /**
+   * @brief Answers every query of a file.
+   *
+   * Invalid rows get a response with an `error` field, and do not stop the run.
+   *
+   * @param[in] queries_path Path of the CSV file of queries.
+   * @param[in] output_path Path of the JSON lines file to write, one response per query.
+   * @throws std::runtime_error If a file cannot be opened, or a required column is missing.
+   */
+  void run(const std::string &queries_path, const std::string &output_path);
+
+private:
+  const Raptor &raptor_; ///< Router answering the queries.
+  ThreadPool pool_; ///< Workers answering the queries.
+
+  /**
+   * @struct Columns
+   * @brief Indexes of the columns of the query file.
+   */
+  struct Columns {
+    std::optional<size_t> id; ///< Index of the id column, if any.
+    size_t source; ///< Index of the source column.
+    std::optional<size_t> target; ///< Index of the target column, if any.
+    size_t date; ///< Index of the date column.
+    size_t time; ///< Index of the time column.
+    std::optional<size_t> latest_time; ///< Index of the latest_time column, if any.
+    std::optional<size_t> criteria; ///< Index of the criteria column, if any.
+  };
+
+  /**
+   * @brief Reads a request from a row of the query file.
+   *
+   * @param[in] row The fields of the row.
+   * @param[in] columns The indexes of the columns.
+   * @param[in] number The number of the row, starting at 1.
+   * @return The request.
+   */
+  static QueryRequest readRequest(const std::vector<std::string_view> &row, const Columns &columns, size_t number);
+};
+
+#endif //RAPTOR_BATCHRUNNER_H
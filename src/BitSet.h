@@ -0,0 +1,88 @@
+/**
+ * @file BitSet.h
+ * @brief Defines the BitSet class, a dense set of small integers.
+ *
+ * This header file declares the BitSet class, used for the stops marked in a round of RAPTOR.
+ */
+
+#ifndef RAPTOR_BITSET_H
+#define RAPTOR_BITSET_H
+
+#include <vector>
+#include <cstdint>
+#include <bit>
+#include <algorithm>
+
+/**
+ * @class BitSet
+ * @brief A set of the integers below a fixed bound, stored as one bit each.
+ *
+ * Elements are visited in increasing order, by skipping whole words of unset bits.
+ */
+class BitSet {
+public:
+  /**
+   * @brief Empties the set, and sets the bound of its elements.
+   * @param[in] size The bound of the elements.
+   */
+  void resize(size_t size) {
+    words_.assign((size + 63) / 64, 0);
+    count_ = 0;
+  }
+
+  /**
+   * @brief Empties the set.
+   */
+  void clear() {
+    if (count_ == 0) return;
+    std::fill(words_.begin(), words_.end(), 0);
+    count_ = 0;
+  }
+
+  /**
+   * @brief Adds an element.
+   * @param[in] i The element, below the bound.
+   */
+  void insert(size_t i) {
+    uint64_t bit = uint64_t{1} << (i % 64);
+    if (words_[i / 64] & bit) return;
+    words_[i / 64] |= bit;
+    ++count_;
+  }
+
+  /**
+   * @brief Checks if an element is in the set.
+   * @param[in] i The element, below the bound.
+   * @return True if the element is in the set.
+   */
+  bool contains(size_t i) const { return words_[i / 64] >> (i % 64) & 1; }
+
+  /**
+   * @brief Gets the number of elements.
+   * @return The number of elements.
+   */
+  size_t count() const { return count_; }
+
+  /**
+   * @brief Checks if the set is empty.
+   * @return True if the set has no element.
+   */
+  bool empty() const { return count_ == 0; }
+
+  /**
+   * @brief Applies a function to every element, in increasing order.
+   * @param[in] function The function, called with each element.
+   */
+  template<typename F>
+  void forEach(F &&function) const {
+    for (size_t w = 0; w < words_.size(); ++w)
+      for (uint64_t word = words_[w]; word != 0; word &= word - 1)
+        function(w * 64 + std::countr_zero(word));
+  }
+
+private:
+  std::vector<uint64_t> words_; ///< Bit i % 64 of word i / 64 is set if i is in the set.
+  size_t count_ = 0; ///< Number of elements.
+};
+
+#endif //RAPTOR_BITSET_H
@@ -0,0 +1,160 @@
+/**
+ * @file CsvReader.cpp
+ * @brief CsvReader class implementation
+ *
+ * This file contains the implementation of the CsvReader class, which tokenizes
+ * memory-mapped CSV files without copying their fields.
+ */
+
+#include "CsvReader.h"
+
+#include <stdexcept>
+#include <fcntl.h>    // for open
+#include <sys/mman.h> // for mmap
+#include <sys/stat.h> // for fstat
+#include <unistd.h>   // for close
+
+CsvReader::CsvReader(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Could not open " + path);
+
+  struct stat file_stat{};
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    throw std::runtime_error("Could not open " + path);
+  }
+
+  auto size = static_cast<size_t>(file_stat.st_size);
+  if (size > 0) {
+    void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("Could not map " + path);
+    }
+
+    madvise(address, size, MADV_SEQUENTIAL);
+    storage_ = std::shared_ptr<const void>(address, [size](const void *mapped) {
+      munmap(const_cast<void *>(mapped), size);
+    });
+    data_ = {static_cast<const char *>(address), size};
+  }
+  close(fd); // The mapping stays valid after closing the file
+
+  // Skip the UTF-8 byte order mark, if any
+  if (data_.starts_with("\xEF\xBB\xBF")) position_ = 3;
+
+  std::vector<std::string_view> header;
+  readRow(header);
+  header_.assign(header.begin(), header.end());
+}
+
+CsvReader::CsvReader(std::string_view data, std::vector<std::string> header)
+        : data_(data), header_(std::move(header)) {}
+
+const std::vector<std::string> &CsvReader::getHeader() const {
+  return header_;
+}
+
+std::optional<size_t> CsvReader::findColumn(std::string_view name) const {
+  for (size_t i = 0; i < header_.size(); ++i)
+    if (header_[i] == name) return i;
+  return std::nullopt;
+}
+
+bool CsvReader::readRow(std::vector<std::string_view> &row) {
+  row.clear();
+  unescaped_.clear();
+
+  // Skip blank lines
+  while (position_ < data_.size()) {
+    size_t line_start = position_;
+    while (position_ < data_.size() && (data_[position_] == ' ' || data_[position_] == '\t' || data_[position_] == '\r'))
+      ++position_;
+
+    if (position_ == data_.size()) return false;
+    if (data_[position_] == '\n') {
+      ++position_;
+      continue;
+    }
+
+    position_ = line_start;
+    break;
+  }
+
+  if (position_ >= data_.size()) return false;
+
+  // Leading whitespace of the line is not part of the first field
+  while (data_[position_] == ' ' || data_[position_] == '\t') ++position_;
+
+  while (true) {
+    std::string_view field;
+    size_t end;
+
+    if (position_ < data_.size() && data_[position_] == '"') {
+      ++position_;
+      field = readQuotedField();
+
+      // Ignore anything between the closing quote and the next delimiter
+      end = data_.find_first_of(",\n", position_);
+      if (end == std::string_view::npos) end = data_.size();
+
+    } else {
+      end = data_.find_first_of(",\n", position_);
+      if (end == std::string_view::npos) end = data_.size();
+      field = data_.substr(position_, end - position_);
+
+      // Trailing whitespace of the line, including the CR of CRLF, is not part of the last field
+      if (end == data_.size() || data_[end] == '\n')
+        while (!field.empty() && (field.back() == '\r' || field.back() == ' ' || field.back() == '\t'))
+          field.remove_suffix(1);
+    }
+
+    row.push_back(field);
+    position_ = end + 1;
+
+    if (end == data_.size() || data_[end] == '\n') break;
+    if (position_ == data_.size()) { // The data ends with a delimiter, so the last field is empty
+      row.emplace_back();
+      break;
+    }
+  }
+
+  if (position_ > data_.size()) position_ = data_.size();
+  return true;
+}
+
+std::string_view CsvReader::getRemaining() const {
+  return data_.substr(position_);
+}
+
+bool CsvReader::hasQuotes() const {
+  return data_.find('"', position_) != std::string_view::npos;
+}
+
+std::string_view CsvReader::readQuotedField() {
+  size_t start = position_;
+  std::string *unescaped = nullptr;
+
+  while (true) {
+    size_t quote = data_.find('"', position_);
+    if (quote == std::string_view::npos)
+      throw std::runtime_error("Unterminated quoted field");
+
+    // A doubled quote stands for a single quote inside the field
+    if (quote + 1 < data_.size() && data_[quote + 1] == '"') {
+      if (unescaped == nullptr) unescaped = &unescaped_.emplace_back();
+      unescaped->append(data_.substr(position_, quote + 1 - position_));
+      position_ = quote + 2;
+      continue;
+    }
+
+    std::string_view rest = data_.substr(position_, quote - position_);
+    position_ = quote + 1;
+
+    if (unescaped == nullptr) return data_.substr(start, quote - start);
+
+    unescaped->append(rest);
+    return *unescaped;
+  }
+}
@@ -0,0 +1,100 @@
+/**
+ * @file CsvReader.h
+ * @brief Defines the CsvReader class, a streaming tokenizer for GTFS files.
+ *
+ * This header file declares the CsvReader class, which reads the rows of a CSV file
+ * from a read-only memory-mapped buffer, yielding fields as views instead of copies.
+ */
+
+#ifndef RAPTOR_CSVREADER_H
+#define RAPTOR_CSVREADER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <optional>
+
+/**
+ * @class CsvReader
+ * @brief Reads the rows of a CSV file as views over its contents.
+ *
+ * Fields follow RFC 4180: they are separated by commas, rows end with LF or CRLF,
+ * and quoted fields may contain commas, line breaks and doubled quotes. Unquoted fields
+ * and quoted fields without doubled quotes are views into the file; only fields with
+ * doubled quotes are copied, and their views stay valid until the next row is read.
+ * Blank lines are skipped, and a UTF-8 byte order mark before the header is ignored.
+ */
+class CsvReader {
+public:
+  /**
+   * @brief Memory-maps a CSV file and reads its header row.
+   * @param[in] path Path to the CSV file.
+   * @throws std::runtime_error If the file cannot be opened or mapped.
+   */
+  explicit CsvReader(const std::string &path);
+
+  /**
+   * @brief Reads the rows of a part of a CSV file, with a known header.
+   *
+   * Used to parse line-aligned chunks of a file in parallel. The data is not owned,
+   * and must outlive the reader and the rows it yields.
+   *
+   * @param[in] data The rows to read, starting at the beginning of a row.
+   * @param[in] header The names of the columns.
+   */
+  CsvReader(std::string_view data, std::vector<std::string> header);
+
+  /**
+   * @brief Gets the names of the columns.
+   * @return A constant reference to the header row.
+   */
+  const std::vector<std::string> &getHeader() const;
+
+  /**
+   * @brief Looks up a column by name.
+   * @param[in] name The name of the column.
+   * @return The index of the column, or `std::nullopt` if the file does not have it.
+   */
+  std::optional<size_t> findColumn(std::string_view name) const;
+
+  /**
+   * @brief Reads the next non-blank row.
+   * @param[out] row The fields of the row.
+   * @return True if a row was read, false at the end of the data.
+   * @throws std::runtime_error If a quoted field is not closed.
+   */
+  bool readRow(std::vector<std::string_view> &row);
+
+  /**
+   * @brief Gets the rows that have not been read yet.
+   * @return A view over the remaining data, starting at the beginning of a row.
+   */
+  std::string_view getRemaining() const;
+
+  /**
+   * @brief Checks if the data contains any quote.
+   *
+   * Without quotes, every line break ends a row, so the data can be split at any line break.
+   *
+   * @return True if a quote appears anywhere in the data.
+   */
+  bool hasQuotes() const;
+
+private:
+  std::shared_ptr<const void> storage_; ///< File mapping the data points into, if owned.
+  std::string_view data_; ///< Contents of the file.
+  size_t position_ = 0; ///< Offset of the next row to read.
+  std::vector<std::string> header_; ///< Names of the columns.
+  std::deque<std::string> unescaped_; ///< Copies of the current row's fields that contained doubled quotes.
+
+  /**
+   * @brief Reads a quoted field, starting after its opening quote.
+   * @return A view over the field's contents, without the quotes.
+   * @throws std::runtime_error If the field is not closed.
+   */
+  std::string_view readQuotedField();
+};
+
+#endif //RAPTOR_CSVREADER_H
@@ -37,8 +37,10 @@ struct Date {
 /**
  * @enum Day
  * @brief Represents the current or the next day for calculations.
+ *
+ * Later days are represented by their number of days after the current day.
  */
-enum class Day {
+enum class Day : int {
   CurrentDay, ///< Refers to the current day.
   NextDay     ///< Refers to the next day.
 };
@@ -0,0 +1,50 @@
+/**
+ * @file LabelBags.cpp
+ * @brief LabelBags class implementation
+ *
+ * This file contains the implementation of the LabelBags class, which stores the labels
+ * of a McRAPTOR query and keeps the bag of each stop Pareto-optimal.
+ */
+
+#include "LabelBags.h"
+
+void LabelBags::reset(size_t num_stops) {
+  // A context reused on another timetable starts over
+  if (num_stops != bags_.size()) {
+    bags_.assign(num_stops, {});
+    touched_stops_.clear();
+  }
+
+  for (StopId stop_id: touched_stops_) bags_[stop_id].clear();
+  touched_stops_.clear();
+  labels_.clear();
+}
+
+bool LabelBags::isDominated(StopId stop_id, const Label &label) const {
+  return bags_[stop_id].isDominated({NO_LABEL, label});
+}
+
+std::optional<uint32_t> LabelBags::insert(const Label &label) {
+  Bag &bag = bags_[label.stop_id];
+  if (bag.empty()) touched_stops_.push_back(label.stop_id);
+
+  auto index = static_cast<uint32_t>(labels_.size());
+  if (!bag.insert({index, label})) return std::nullopt;
+
+  labels_.push_back(label);
+  return index;
+}
+
+bool LabelBags::dominates(const Label &label1, const Label &label2) {
+  int agency_changes = label1.agency_changes + (label1.agency != NO_AGENCY && label1.agency != label2.agency);
+
+  return label1.trips <= label2.trips
+         && label1.arrival_seconds <= label2.arrival_seconds
+         && label1.walking_seconds <= label2.walking_seconds
+         && agency_changes <= label2.agency_changes
+         && label1.fare_zones <= label2.fare_zones;
+}
+
+bool BagLabel::dominates(const BagLabel &bag_label1, const BagLabel &bag_label2) {
+  return LabelBags::dominates(bag_label1.label, bag_label2.label);
+}
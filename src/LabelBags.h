@@ -0,0 +1,143 @@
+/**
+ * @file LabelBags.h
+ * @brief Defines the LabelBags class, the Pareto sets of labels of every stop in a McRAPTOR query.
+ *
+ * This header file declares the Label struct, the label of a stop under several criteria, and the LabelBags
+ * class, which keeps a bag of mutually non-dominated labels per stop, reused from query to query.
+ */
+
+#ifndef RAPTOR_LABELBAGS_H
+#define RAPTOR_LABELBAGS_H
+
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <limits>
+
+#include "NetworkObjects/DataStructures.h"
+#include "ParetoSet.h"
+
+static constexpr uint32_t NO_LABEL = std::numeric_limits<uint32_t>::max(); ///< Parent of the source label.
+
+/**
+ * @struct Label
+ * @brief How a stop can be reached, with the value of every criterion.
+ *
+ * Criteria the query does not optimise stay at 0, so that they never tell labels apart.
+ */
+struct Label {
+  int arrival_seconds = UNREACHED; ///< Arrival time in seconds, or departure from the boarding stop while riding.
+  int trips = 0;                   ///< Number of trips taken, which is the round the label was found in.
+  int walking_seconds = 0;         ///< Seconds walked, if walking time is a criterion.
+  int agency_changes = 0;          ///< Changes between vehicles of different agencies, if a criterion.
+  int fare_zones = 0;              ///< Fare zone boundaries crossed on board, if a criterion.
+  AgencyId agency = NO_AGENCY;     ///< Agency of the last trip taken, if agency changes are a criterion.
+  StopId stop_id = NO_STOP;        ///< Index of the stop reached.
+  uint32_t parent = NO_LABEL;      ///< Index of the label this one extends, or `NO_LABEL` for the source.
+  TripId parent_trip_id = NO_TRIP; ///< Trip taken from the parent's stop, or `NO_TRIP` for footpaths.
+  uint32_t boarding_position = 0;  ///< Position of the parent's stop in the route of the trip.
+  int trip_day = 0;                ///< Service day of the trip, in days from the query date.
+};
+
+/**
+ * @struct BagLabel
+ * @brief A label in a bag, with its index in the store of labels.
+ *
+ * Bags hold copies of their labels, so that comparing labels does not go through the store.
+ */
+struct BagLabel {
+  uint32_t index; ///< Index of the label in the store.
+  Label label;    ///< The label.
+
+  /**
+   * @brief Gets the criterion bags are sorted by.
+   * @param[in] bag_label The label.
+   * @return The arrival time of the label.
+   */
+  static int key(const BagLabel &bag_label) { return bag_label.label.arrival_seconds; }
+
+  /**
+   * @brief Compares two labels of the same stop, as LabelBags::dominates().
+   * @param[in] bag_label1 The first label.
+   * @param[in] bag_label2 The second label.
+   * @return True if the first label is at least as good as the second in every criterion.
+   */
+  static bool dominates(const BagLabel &bag_label1, const BagLabel &bag_label2);
+
+  static constexpr bool SKYLINE = false; ///< Labels are compared by more criteria than arrival time.
+};
+
+using Bag = ParetoSet<BagLabel, BagLabel>; ///< Labels of a stop that no other label of the stop dominates.
+
+/**
+ * @class LabelBags
+ * @brief The labels of a query, and the bag of each stop.
+ *
+ * Labels are never removed from the store, so that parents stay valid for reconstructing journeys,
+ * but a label dominated by a new one leaves its bag. Bags are sorted by arrival time.
+ */
+class LabelBags {
+public:
+  /**
+   * @brief Starts a query, emptying the store and the bags.
+   *
+   * Only the bags written by the previous query are cleared.
+   *
+   * @param[in] num_stops The number of stops of the timetable queried.
+   */
+  void reset(size_t num_stops);
+
+  /**
+   * @brief Gets a label of the store.
+   *
+   * @param[in] label The index of the label.
+   * @return The label. The reference is invalidated by insertions.
+   */
+  const Label &get(uint32_t label) const { return labels_[label]; }
+
+  /**
+   * @brief Gets the bag of a stop.
+   *
+   * @param[in] stop_id The index of the stop.
+   * @return The labels of the bag, by arrival time. Iterators are invalidated by insertions.
+   */
+  const Bag &getBag(StopId stop_id) const { return bags_[stop_id]; }
+
+  /**
+   * @brief Checks if a label is dominated by a label of a bag.
+   *
+   * @param[in] stop_id The index of the stop of the bag.
+   * @param[in] label The label, of any stop.
+   * @return True if a label of the bag is at least as good in every criterion.
+   */
+  bool isDominated(StopId stop_id, const Label &label) const;
+
+  /**
+   * @brief Adds a label to the bag of its stop, unless it is dominated there.
+   *
+   * The labels of the bag it dominates are removed from the bag.
+   *
+   * @param[in] label The label.
+   * @return The index of the label in the store, or `std::nullopt` if it was dominated.
+   */
+  std::optional<uint32_t> insert(const Label &label);
+
+  /**
+   * @brief Compares two labels of the same stop.
+   *
+   * A label with an agency needs one more change than its value to board a vehicle of another agency,
+   * so it only dominates labels of other agencies with that change counted.
+   *
+   * @param[in] label1 The first label.
+   * @param[in] label2 The second label.
+   * @return True if the first label is at least as good as the second in every criterion.
+   */
+  static bool dominates(const Label &label1, const Label &label2);
+
+private:
+  std::vector<Label> labels_; ///< Labels of the query, by index.
+  std::vector<Bag> bags_; ///< Bag of each stop.
+  std::vector<StopId> touched_stops_; ///< Stops whose bag is not empty.
+};
+
+#endif //RAPTOR_LABELBAGS_H
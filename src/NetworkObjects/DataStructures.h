@@ -4,7 +4,6 @@
  *
  * This header file includes declarations for structs like `Query`, `StopInfo`, `JourneyStep`,
  * and `Journey`, which are used to represent transit queries, stop information, and journey details.
- * It also provides hash functions for specific pair-based keys.
  */
 
 #ifndef DATASTRUCTURES_H
@@ -15,10 +14,40 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <limits>
 
 #include "../DateTime.h"
 
-class Stop;
+using StopId = uint32_t;    ///< Dense index of a stop in the Timetable.
+using RouteId = uint32_t;   ///< Dense index of a route (stop pattern) in the Timetable.
+using TripId = uint32_t;    ///< Dense index of a trip in the Timetable.
+using ServiceId = uint32_t; ///< Dense index of a service calendar in the Timetable.
+using AgencyId = uint32_t;  ///< Dense index of an agency in the Timetable.
+
+using RoundArrivals = std::vector<std::vector<std::optional<int>>>; ///< Arrival in seconds at each stop, after each round.
+
+static constexpr int UNREACHED = std::numeric_limits<int>::max(); ///< Arrival time of unreached stops.
+static constexpr TripId NO_TRIP = std::numeric_limits<TripId>::max(); ///< Parent trip of footpaths and first stops.
+static constexpr StopId NO_STOP = std::numeric_limits<StopId>::max(); ///< Parent stop of first stops.
+static constexpr AgencyId NO_AGENCY = std::numeric_limits<AgencyId>::max(); ///< Agency before any trip is taken.
+static constexpr uint32_t NO_POSITION = std::numeric_limits<uint32_t>::max(); ///< Position of routes not queued.
+
+static constexpr int DEFAULT_MAX_WALKING_DURATION = 20 * 60; ///< Longest footpath generated by default, in seconds.
+static constexpr int DEFAULT_HORIZON_DAYS = 2; ///< Service days searched by default: the query date and the next.
+
+/**
+ * @enum Criterion
+ * @brief A criterion that multi-criteria queries optimise, besides arrival time and number of trips.
+ */
+enum class Criterion : uint8_t {
+  WalkingTime,   ///< Seconds spent walking between stops.
+  AgencyChanges, ///< Changes from a vehicle of one agency to a vehicle of another.
+  FareZones,     ///< Fare zone boundaries crossed on board.
+};
+
+static constexpr size_t NUM_CRITERIA = 3; ///< Number of values of Criterion.
 
 /**
  * @struct Query
@@ -29,24 +58,28 @@ class Stop;
  */
 struct Query {
   std::string source_id;   ///< ID of the source stop.
-  std::string target_id;   ///< ID of the target stop.
+  std::string target_id;   ///< ID of the target stop, empty for one-to-all queries.
   Date date;               ///< Date of the journey.
-  Time departure_time;     ///< Desired departure time for the journey.
+  Time departure_time;     ///< Desired departure time for the journey, or start of the departure window.
+  std::optional<Time> latest_departure_time; ///< End of the departure window of profile queries.
+  int horizon_days = DEFAULT_HORIZON_DAYS; ///< Service days, from the query date on, whose trips may be taken.
+  std::vector<Criterion> criteria; ///< Criteria optimised by multi-criteria queries, besides arrival and trips.
 };
 
 /**
  * @struct StopInfo
  * @brief Represents information about a transit stop during a journey.
  *
- * This structure holds details about a stop's arrival time, the trip and stop
- * it depends on, and the day of operation. Values are optional to handle
- * cases where a stop is unreachable or is a starting point.
+ * This structure holds the label of a stop in a round: its arrival time, and the trip and stop
+ * it was reached from. Missing values are sentinels, so that labels are plain integers,
+ * and the day of arrival follows from the arrival time.
  */
 struct StopInfo {
-  std::optional<int> arrival_seconds;          ///< Arrival time in seconds, or `std::nullopt` if unreachable.
-  std::optional<std::string> parent_trip_id;   ///< ID of the parent trip, or `std::nullopt` for footpaths.
-  std::optional<std::string> parent_stop_id;   ///< ID of the parent stop, or `std::nullopt` for first stops.
-  std::optional<Day> day;                      ///< Day of arrival, or `std::nullopt` if unreachable.
+  int arrival_seconds = UNREACHED;      ///< Arrival time in seconds, or `UNREACHED`.
+  TripId parent_trip_id = NO_TRIP;      ///< Index of the parent trip, or `NO_TRIP` for footpaths and first stops.
+  StopId parent_stop_id = NO_STOP;      ///< Index of the parent stop, or `NO_STOP` for first stops.
+  uint32_t boarding_position = 0;       ///< Position of the parent stop in the route of the parent trip.
+  int trip_day = 0;                     ///< Service day of the parent trip, in days from the query date.
 };
 
 /**
@@ -55,12 +88,13 @@ struct StopInfo {
  *
  * A journey step can correspond to a trip or a footpath. It contains information
  * about the source and destination stops, departure and arrival times, and duration.
+ * Trips, agencies and stops are Timetable indices, whose IDs and names are only looked up when displayed.
  */
 struct JourneyStep {
-  std::optional<std::string> trip_id;      ///< ID of the trip, or `std::nullopt` for footpaths.
-  std::optional<std::string> agency_name;  ///< Name of the agency, or `std::nullopt` for footpaths.
-  Stop *src_stop{};                        ///< Pointer to the source stop.
-  Stop *dest_stop{};                       ///< Pointer to the destination stop.
+  TripId trip_id = NO_TRIP;                ///< Index of the trip in the Timetable, or `NO_TRIP` for footpaths.
+  AgencyId agency_id = NO_AGENCY;          ///< Index of the agency in the Timetable, or `NO_AGENCY` for footpaths.
+  StopId src_stop{};                       ///< Index of the source stop in the Timetable.
+  StopId dest_stop{};                      ///< Index of the destination stop in the Timetable.
 
   int departure_secs{};                    ///< Departure time in seconds from midnight.
   Day day{};                               ///< Day of the journey step.
@@ -86,42 +120,4 @@ struct Journey {
   int duration;                            ///< Total duration of the journey in seconds.
 };
 
-/**
- * @struct pair_hash
- * @brief Hash function for a pair of strings.
- *
- * Provides a custom hash implementation for pairs of strings,
- * used in unordered containers like `std::unordered_map` and `std::unordered_set`.
- */
-struct pair_hash {
-  /**
-   * @brief Computes the hash value for a pair of strings.
-   * @param pair The pair of strings to hash.
-   * @return The computed hash value.
-   */
-  std::size_t operator()(const std::pair<std::string, std::string> &pair) const {
-    return std::hash<std::string>()(pair.first) ^ std::hash<std::string>()(pair.second);
-  }
-};
-
-/**
- * @struct nested_pair_hash
- * @brief Hash function for nested pairs of strings.
- *
- * Provides a custom hash implementation for nested pairs of strings,
- * used in unordered containers for hierarchical keys.
- */
-struct nested_pair_hash {
-  /**
-   * @brief Computes the hash value for a nested pair of strings.
-   * @param nested_pair The nested pair to hash.
-   * @return The computed hash value.
-   */
-  std::size_t operator()(const std::pair<std::pair<std::string, std::string>, std::string> &nested_pair) const {
-    std::size_t hash1 = pair_hash{}(nested_pair.first);  // Hash of internal part
-    std::size_t hash2 = std::hash<std::string>{}(nested_pair.second);
-    return hash1 ^ (hash2 << 1);
-  }
-};
-
 #endif //DATASTRUCTURES_H
@@ -0,0 +1,252 @@
+/**
+ * @file GTFSFeed.cpp
+ * @brief GTFSFeed class implementation
+ *
+ * This file contains the implementation of the GTFSFeed class and its ExtraColumns store,
+ * which group the stop times by trip and merge the tables of several feeds.
+ */
+
+#include "GTFSFeed.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "../ThreadPool.h"
+
+const std::vector<std::string> &ExtraColumns::getNames() const {
+  return names_;
+}
+
+size_t ExtraColumns::addColumn(const std::string &name, size_t num_rows) {
+  auto it = std::find(names_.begin(), names_.end(), name);
+  if (it != names_.end()) return it - names_.begin();
+
+  names_.push_back(name);
+  offsets_.emplace_back(num_rows + 1, 0);
+  chars_.emplace_back();
+  return names_.size() - 1;
+}
+
+void ExtraColumns::append(size_t column, std::string_view value) {
+  chars_[column].append(value);
+  offsets_[column].push_back(chars_[column].size());
+}
+
+void ExtraColumns::pad(size_t num_rows) {
+  for (auto &offsets: offsets_)
+    if (offsets.size() < num_rows + 1) offsets.resize(num_rows + 1, offsets.back());
+}
+
+void ExtraColumns::appendRows(const ExtraColumns &other, std::span<const uint32_t> rows, size_t num_rows) {
+  pad(num_rows);
+
+  for (size_t other_column = 0; other_column < other.names_.size(); ++other_column) {
+    size_t column = addColumn(other.names_[other_column], num_rows);
+
+    for (uint32_t row: rows)
+      append(column, other.get(other_column, row));
+  }
+
+  pad(num_rows + rows.size());
+}
+
+std::optional<std::string_view> ExtraColumns::get(std::string_view name, size_t row) const {
+  auto it = std::find(names_.begin(), names_.end(), name);
+  if (it == names_.end()) return std::nullopt;
+
+  return get(it - names_.begin(), row);
+}
+
+std::string_view ExtraColumns::get(size_t column, size_t row) const {
+  const auto &offsets = offsets_[column];
+  return std::string_view(chars_[column]).substr(offsets[row], offsets[row + 1] - offsets[row]);
+}
+
+/**
+ * @brief Appends the IDs of another table that a table does not have yet.
+ * @param[in,out] ids The interned IDs of the table.
+ * @param[in] other_ids The IDs of the other table, already interned in the table's interner.
+ * @param[out] appended The rows of the other table that were appended, in order.
+ * @return The row of each row of the other table in the table.
+ */
+static std::vector<uint32_t> mergeIds(std::vector<StringId> &ids, const std::vector<StringId> &other_ids,
+                                      std::vector<uint32_t> &appended) {
+  std::unordered_map<StringId, uint32_t> index;
+  index.reserve(ids.size() + other_ids.size());
+  for (uint32_t row = 0; row < ids.size(); ++row)
+    index.emplace(ids[row], row);
+
+  std::vector<uint32_t> rows(other_ids.size());
+  for (uint32_t other_row = 0; other_row < other_ids.size(); ++other_row) {
+    auto [it, inserted] = index.try_emplace(other_ids[other_row], static_cast<uint32_t>(ids.size()));
+    if (inserted) {
+      ids.push_back(other_ids[other_row]);
+      appended.push_back(other_row);
+    }
+    rows[other_row] = it->second;
+  }
+
+  return rows;
+}
+
+/**
+ * @brief Appends some rows of another column to a column.
+ * @param[in,out] column The column.
+ * @param[in] other The other column.
+ * @param[in] rows The rows of the other column to append, in order.
+ */
+template<typename T>
+static void appendColumn(std::vector<T> &column, const std::vector<T> &other, std::span<const uint32_t> rows) {
+  column.reserve(column.size() + rows.size());
+  for (uint32_t row: rows)
+    column.push_back(other[row]);
+}
+
+/**
+ * @brief Appends some rows of another column of references to a column, translating the references.
+ * @param[in,out] column The column.
+ * @param[in] other The other column.
+ * @param[in] rows The rows of the other column to append, in order.
+ * @param[in] references The row in this feed of each row referenced by the other column.
+ */
+static void appendReferences(std::vector<uint32_t> &column, const std::vector<uint32_t> &other,
+                             std::span<const uint32_t> rows, const std::vector<uint32_t> &references) {
+  column.reserve(column.size() + rows.size());
+  for (uint32_t row: rows)
+    column.push_back(references[other[row]]);
+}
+
+void GTFSFeed::associate(ThreadPool *pool) {
+  // Bucket the stop times by trip, keeping the file order within each trip
+  trip_stop_times_offsets_.assign(trips.size() + 1, 0);
+  for (uint32_t trip: stop_times.trip)
+    ++trip_stop_times_offsets_[trip + 1];
+  for (size_t trip = 0; trip < trips.size(); ++trip)
+    trip_stop_times_offsets_[trip + 1] += trip_stop_times_offsets_[trip];
+
+  trip_stop_times_.resize(stop_times.size());
+  std::vector<uint32_t> next(trip_stop_times_offsets_.begin(), trip_stop_times_offsets_.end() - 1);
+  for (uint32_t row = 0; row < stop_times.size(); ++row)
+    trip_stop_times_[next[stop_times.trip[row]]++] = row;
+
+  // Sort each trip's stop times by stop sequence, in parallel since trips are independent
+  auto sortTrip = [this](size_t trip) {
+    std::stable_sort(trip_stop_times_.begin() + trip_stop_times_offsets_[trip],
+                     trip_stop_times_.begin() + trip_stop_times_offsets_[trip + 1],
+                     [this](uint32_t a, uint32_t b) {
+                       return stop_times.stop_sequence[a] < stop_times.stop_sequence[b];
+                     });
+  };
+
+  if (pool != nullptr) {
+    pool->parallelFor(trips.size(), sortTrip);
+  } else {
+    for (size_t trip = 0; trip < trips.size(); ++trip)
+      sortTrip(trip);
+  }
+}
+
+std::span<const uint32_t> GTFSFeed::getTripStopTimes(uint32_t trip) const {
+  return std::span<const uint32_t>(trip_stop_times_).subspan(
+          trip_stop_times_offsets_[trip], trip_stop_times_offsets_[trip + 1] - trip_stop_times_offsets_[trip]);
+}
+
+void GTFSFeed::merge(const GTFSFeed &other, ThreadPool *pool) {
+  // Translates the IDs of a table of the other feed into this feed's interner
+  auto intern = [&](const std::vector<StringId> &other_ids) {
+    if (other.strings == strings) return other_ids;
+
+    std::vector<StringId> ids;
+    ids.reserve(other_ids.size());
+    for (StringId id: other_ids)
+      ids.push_back(strings->intern(other.strings->get(id)));
+    return ids;
+  };
+
+  std::vector<uint32_t> appended;
+
+  size_t num_rows = agencies.size();
+  std::vector<uint32_t> agency_rows = mergeIds(agencies.agency_id, intern(other.agencies.agency_id), appended);
+  appendColumn(agencies.agency_name, other.agencies.agency_name, appended);
+  agencies.extra.appendRows(other.agencies.extra, appended, num_rows);
+
+  appended.clear();
+  num_rows = calendars.size();
+  std::vector<uint32_t> service_rows = mergeIds(calendars.service_id, intern(other.calendars.service_id), appended);
+  appendColumn(calendars.weekdays, other.calendars.weekdays, appended);
+  appendColumn(calendars.start_date, other.calendars.start_date, appended);
+  appendColumn(calendars.end_date, other.calendars.end_date, appended);
+  calendars.extra.appendRows(other.calendars.extra, appended, num_rows);
+
+  // Exceptions of services this feed already has are skipped
+  std::vector<bool> new_service(other.calendars.size(), false);
+  for (uint32_t service: appended)
+    new_service[service] = true;
+
+  appended.clear();
+  num_rows = calendar_dates.size();
+  for (uint32_t row = 0; row < other.calendar_dates.size(); ++row)
+    if (new_service[other.calendar_dates.service[row]]) appended.push_back(row);
+
+  appendReferences(calendar_dates.service, other.calendar_dates.service, appended, service_rows);
+  appendColumn(calendar_dates.date, other.calendar_dates.date, appended);
+  appendColumn(calendar_dates.exception_type, other.calendar_dates.exception_type, appended);
+  calendar_dates.extra.appendRows(other.calendar_dates.extra, appended, num_rows);
+
+  appended.clear();
+  num_rows = routes.size();
+  std::vector<uint32_t> route_rows = mergeIds(routes.route_id, intern(other.routes.route_id), appended);
+  appendReferences(routes.agency, other.routes.agency, appended, agency_rows);
+  routes.extra.appendRows(other.routes.extra, appended, num_rows);
+
+  appended.clear();
+  num_rows = stops.size();
+  std::vector<uint32_t> stop_rows = mergeIds(stops.stop_id, intern(other.stops.stop_id), appended);
+  appendColumn(stops.stop_name, other.stops.stop_name, appended);
+  appendColumn(stops.stop_lat, other.stops.stop_lat, appended);
+  appendColumn(stops.stop_lon, other.stops.stop_lon, appended);
+  stops.extra.appendRows(other.stops.extra, appended, num_rows);
+
+  // Transfers from stops this feed already has are skipped
+  std::vector<bool> new_stop(other.stops.size(), false);
+  for (uint32_t stop: appended)
+    new_stop[stop] = true;
+
+  appended.clear();
+  num_rows = transfers.size();
+  for (uint32_t row = 0; row < other.transfers.size(); ++row)
+    if (new_stop[other.transfers.from_stop[row]]) appended.push_back(row);
+
+  appendReferences(transfers.from_stop, other.transfers.from_stop, appended, stop_rows);
+  appendReferences(transfers.to_stop, other.transfers.to_stop, appended, stop_rows);
+  appendColumn(transfers.transfer_type, other.transfers.transfer_type, appended);
+  appendColumn(transfers.min_transfer_time, other.transfers.min_transfer_time, appended);
+  transfers.extra.appendRows(other.transfers.extra, appended, num_rows);
+
+  appended.clear();
+  num_rows = trips.size();
+  std::vector<uint32_t> trip_rows = mergeIds(trips.trip_id, intern(other.trips.trip_id), appended);
+  appendReferences(trips.route, other.trips.route, appended, route_rows);
+  appendReferences(trips.service, other.trips.service, appended, service_rows);
+  appendColumn(trips.direction_id, other.trips.direction_id, appended);
+  trips.extra.appendRows(other.trips.extra, appended, num_rows);
+
+  // Stop times of trips this feed already has are skipped
+  std::vector<bool> new_trip(other.trips.size(), false);
+  for (uint32_t trip: appended)
+    new_trip[trip] = true;
+
+  appended.clear();
+  num_rows = stop_times.size();
+  for (uint32_t row = 0; row < other.stop_times.size(); ++row)
+    if (new_trip[other.stop_times.trip[row]]) appended.push_back(row);
+
+  appendReferences(stop_times.trip, other.stop_times.trip, appended, trip_rows);
+  appendReferences(stop_times.stop, other.stop_times.stop, appended, stop_rows);
+  appendColumn(stop_times.stop_sequence, other.stop_times.stop_sequence, appended);
+  appendColumn(stop_times.arrival_seconds, other.stop_times.arrival_seconds, appended);
+  appendColumn(stop_times.departure_seconds, other.stop_times.departure_seconds, appended);
+  stop_times.extra.appendRows(other.stop_times.extra, appended, num_rows);
+
+  associate(pool);
+}
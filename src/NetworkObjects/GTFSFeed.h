@@ -0,0 +1,280 @@
+/**
+ * @file GTFSFeed.h
+ * @brief Defines the GTFSFeed class, a typed, columnar store of the GTFS entities.
+ *
+ * This header file declares one structure-of-arrays table per GTFS file (agencies, calendars,
+ * routes, stops, trips and stop times). Columns used by the algorithm are typed, IDs are interned,
+ * references between entities are row indices, and any other column of the files is kept in an ExtraColumns bag.
+ */
+
+#ifndef RAPTOR_GTFSFEED_H
+#define RAPTOR_GTFSFEED_H
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include <memory>
+
+#include "../StringInterner.h"
+
+class ThreadPool;
+
+/**
+ * @class ExtraColumns
+ * @brief Column-major store of the optional columns a table does not type.
+ *
+ * Each column stores its values as concatenated characters and offsets, so an empty value
+ * only costs its offset.
+ */
+class ExtraColumns {
+public:
+  /**
+   * @brief Gets the names of the columns.
+   * @return A constant reference to the column names.
+   */
+  const std::vector<std::string> &getNames() const;
+
+  /**
+   * @brief Adds a column, empty for the rows already stored.
+   * @param[in] name The name of the column.
+   * @param[in] num_rows The number of rows already stored.
+   * @return The index of the column. An existing column with the same name is reused.
+   */
+  size_t addColumn(const std::string &name, size_t num_rows);
+
+  /**
+   * @brief Appends a value to a column.
+   * @param[in] column The index of the column.
+   * @param[in] value The value.
+   */
+  void append(size_t column, std::string_view value);
+
+  /**
+   * @brief Appends empty values to every column shorter than a number of rows.
+   * @param[in] num_rows The number of rows every column must have.
+   */
+  void pad(size_t num_rows);
+
+  /**
+   * @brief Appends some rows of another store, matching columns by name.
+   * @param[in] other The store to copy from.
+   * @param[in] rows The rows of other to append, in order.
+   * @param[in] num_rows The number of rows already stored.
+   */
+  void appendRows(const ExtraColumns &other, std::span<const uint32_t> rows, size_t num_rows);
+
+  /**
+   * @brief Gets a value.
+   * @param[in] name The name of the column.
+   * @param[in] row The row.
+   * @return The value, or `std::nullopt` if the table has no such column.
+   */
+  std::optional<std::string_view> get(std::string_view name, size_t row) const;
+
+  /**
+   * @brief Gets a value.
+   * @param[in] column The index of the column.
+   * @param[in] row The row.
+   * @return The value, empty if the row did not have the column.
+   */
+  std::string_view get(size_t column, size_t row) const;
+
+private:
+  std::vector<std::string> names_; ///< Name of each column.
+  std::vector<std::vector<uint32_t>> offsets_; ///< Offset of each value in chars_, plus a final sentinel, per column.
+  std::vector<std::string> chars_; ///< Concatenated values, per column.
+};
+
+/**
+ * @struct AgencyTable
+ * @brief Rows of agency.txt.
+ */
+struct AgencyTable {
+  std::vector<StringId> agency_id;      ///< Interned ID of each agency. Empty if the feed has a single agency without ID.
+  std::vector<std::string> agency_name; ///< Name of each agency.
+  ExtraColumns extra;                   ///< Other columns.
+
+  /**
+   * @brief Gets the number of rows.
+   * @return The number of agencies.
+   */
+  size_t size() const { return agency_id.size(); }
+};
+
+/**
+ * @struct CalendarTable
+ * @brief Rows of calendar.txt.
+ */
+struct CalendarTable {
+  std::vector<StringId> service_id;   ///< Interned ID of each service.
+  std::vector<uint8_t> weekdays;       ///< Bit i is set if the service runs on weekday i (0 = Sunday).
+  std::vector<int> start_date;         ///< First active date, as YYYYMMDD.
+  std::vector<int> end_date;           ///< Last active date, as YYYYMMDD.
+  ExtraColumns extra;                  ///< Other columns.
+
+  /**
+   * @brief Gets the number of rows.
+   * @return The number of services.
+   */
+  size_t size() const { return service_id.size(); }
+};
+
+/**
+ * @struct CalendarDateTable
+ * @brief Rows of calendar_dates.txt.
+ */
+struct CalendarDateTable {
+  std::vector<uint32_t> service;       ///< Row of the service calendar of each exception.
+  std::vector<int> date;               ///< Date of each exception, as YYYYMMDD.
+  std::vector<uint8_t> exception_type; ///< 1 if the service is added on the date, 2 if it is removed.
+  ExtraColumns extra;                  ///< Other columns.
+
+  /**
+   * @brief Gets the number of rows.
+   * @return The number of exceptions.
+   */
+  size_t size() const { return service.size(); }
+};
+
+/**
+ * @struct RouteTable
+ * @brief Rows of routes.txt.
+ */
+struct RouteTable {
+  std::vector<StringId> route_id;    ///< Interned ID of each route.
+  std::vector<uint32_t> agency;      ///< Row of the agency operating each route.
+  ExtraColumns extra;                ///< Other columns.
+
+  /**
+   * @brief Gets the number of rows.
+   * @return The number of routes.
+   */
+  size_t size() const { return route_id.size(); }
+};
+
+/**
+ * @struct StopTable
+ * @brief Rows of stops.txt.
+ */
+struct StopTable {
+  std::vector<StringId> stop_id;      ///< Interned ID of each stop.
+  std::vector<std::string> stop_name; ///< Name of each stop.
+  std::vector<double> stop_lat;       ///< Latitude of each stop, in decimal degrees.
+  std::vector<double> stop_lon;       ///< Longitude of each stop, in decimal degrees.
+  ExtraColumns extra;                 ///< Other columns.
+
+  /**
+   * @brief Gets the number of rows.
+   * @return The number of stops.
+   */
+  size_t size() const { return stop_id.size(); }
+};
+
+/**
+ * @struct TripTable
+ * @brief Rows of trips.txt.
+ */
+struct TripTable {
+  std::vector<StringId> trip_id;     ///< Interned ID of each trip.
+  std::vector<uint32_t> route;       ///< Row of the route of each trip.
+  std::vector<uint32_t> service;     ///< Row of the service calendar of each trip.
+  std::vector<uint8_t> direction_id; ///< Direction of each trip, 0 if not given.
+  ExtraColumns extra;                ///< Other columns.
+
+  /**
+   * @brief Gets the number of rows.
+   * @return The number of trips.
+   */
+  size_t size() const { return trip_id.size(); }
+};
+
+/**
+ * @struct StopTimeTable
+ * @brief Rows of stop_times.txt.
+ */
+struct StopTimeTable {
+  std::vector<uint32_t> trip;           ///< Row of the trip of each stop time.
+  std::vector<uint32_t> stop;           ///< Row of the stop of each stop time.
+  std::vector<int> stop_sequence;       ///< Position of each stop time in its trip.
+  std::vector<int> arrival_seconds;     ///< Arrival time in seconds from midnight of the service day.
+  std::vector<int> departure_seconds;   ///< Departure time in seconds from midnight of the service day.
+  ExtraColumns extra;                   ///< Other columns.
+
+  /**
+   * @brief Gets the number of rows.
+   * @return The number of stop times.
+   */
+  size_t size() const { return trip.size(); }
+};
+
+/**
+ * @struct TransferTable
+ * @brief Rows of transfers.txt.
+ */
+struct TransferTable {
+  std::vector<uint32_t> from_stop;       ///< Row of the stop each transfer leaves from.
+  std::vector<uint32_t> to_stop;         ///< Row of the stop each transfer arrives at.
+  std::vector<uint8_t> transfer_type;    ///< 0 recommended, 1 timed, 2 with a minimum time, 3 not possible.
+  std::vector<int> min_transfer_time;    ///< Minimum time of each transfer in seconds, or -1 if not given.
+  ExtraColumns extra;                    ///< Other columns.
+
+  /**
+   * @brief Gets the number of rows.
+   * @return The number of transfers.
+   */
+  size_t size() const { return from_stop.size(); }
+};
+
+/**
+ * @class GTFSFeed
+ * @brief Tables of one or more GTFS feeds.
+ */
+class GTFSFeed {
+public:
+  std::shared_ptr<StringInterner> strings = std::make_shared<StringInterner>(); ///< IDs of every table, which parsers of several feeds may share.
+  AgencyTable agencies;     ///< Rows of agency.txt.
+  CalendarTable calendars;  ///< Rows of calendar.txt, and services only found in calendar_dates.txt.
+  CalendarDateTable calendar_dates; ///< Rows of calendar_dates.txt.
+  RouteTable routes;        ///< Rows of routes.txt.
+  StopTable stops;          ///< Rows of stops.txt.
+  TripTable trips;          ///< Rows of trips.txt.
+  StopTimeTable stop_times; ///< Rows of stop_times.txt.
+  TransferTable transfers;  ///< Rows of transfers.txt.
+
+  /**
+   * @brief Groups the stop times by trip, sorted by stop sequence.
+   *
+   * Must be called after the tables are filled, before getTripStopTimes().
+   *
+   * @param[in] pool The thread pool on which the trips are sorted, or `nullptr` to sort sequentially.
+   */
+  void associate(ThreadPool *pool = nullptr);
+
+  /**
+   * @brief Gets the stop times of a trip.
+   * @param[in] trip The row of the trip.
+   * @return A view over the rows of the trip's stop times, sorted by stop sequence.
+   */
+  std::span<const uint32_t> getTripStopTimes(uint32_t trip) const;
+
+  /**
+   * @brief Appends the rows of another feed.
+   *
+   * Rows whose ID already exists in this feed are skipped, as are the stop times of skipped trips,
+   * so the first feed merged wins. The merged feed is associated again.
+   * IDs are interned again unless both feeds share the same interner.
+   *
+   * @param[in] other The feed to append.
+   * @param[in] pool The thread pool on which the trips are sorted, or `nullptr` to sort sequentially.
+   */
+  void merge(const GTFSFeed &other, ThreadPool *pool = nullptr);
+
+private:
+  std::vector<uint32_t> trip_stop_times_offsets_; ///< Offsets of each trip in trip_stop_times_, plus a final sentinel.
+  std::vector<uint32_t> trip_stop_times_; ///< Rows of the stop times of each trip, sorted by stop sequence.
+};
+
+#endif //RAPTOR_GTFSFEED_H
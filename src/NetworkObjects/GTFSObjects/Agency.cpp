@@ -1,14 +0,0 @@
-/**
- * @file Agency.cpp
- * @brief Implements the Agency class.
- *
- * This file contains the implementation of the Agency class, which represents
- * transit agencies in the GTFS dataset.
- *
- * @note Currently, this file serves as a placeholder for future extensions.
- *
- * @autor Maria
- * @date 11/20/2024
- */
-
-#include "Agency.h"
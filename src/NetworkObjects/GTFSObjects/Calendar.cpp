@@ -1,14 +0,0 @@
-/**
- * @file Calendar.cpp
- * @brief Implements the Calendar class.
- *
- * This file contains the implementation of the Calendar class, which represents
- * active days of a calendar in the GTFS dataset.
- *
- * @note Currently, this file serves as a placeholder for future extensions.
- *
- * @autor Maria
- * @date 11/20/2024
- */
-
-#include "Calendar.h"
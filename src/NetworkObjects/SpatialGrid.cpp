@@ -0,0 +1,53 @@
+/**
+ * @file SpatialGrid.cpp
+ * @brief SpatialGrid class implementation
+ *
+ * This file contains the implementation of the SpatialGrid class, a uniform grid index
+ * used to find nearby stops.
+ */
+
+#include "SpatialGrid.h"
+
+#include <cmath>
+#include <stdexcept>
+
+SpatialGrid::SpatialGrid(std::vector<Coordinates> points, double cell_size)
+        : points_(std::move(points)), cell_size_(cell_size) {
+  if (!(cell_size_ > 0))
+    throw std::runtime_error("Spatial grid cell size must be positive.");
+
+  for (uint32_t i = 0; i < points_.size(); ++i)
+    cells_[cellKey(cellIndex(points_[i].lat), cellIndex(points_[i].lon))].push_back(i);
+}
+
+std::vector<uint32_t> SpatialGrid::findWithin(const Coordinates &location, double radius) const {
+  std::vector<uint32_t> found;
+
+  int64_t row = cellIndex(location.lat);
+  int64_t column = cellIndex(location.lon);
+
+  // The radius does not exceed the cell size, so only the 3x3 neighbouring cells can contain matches
+  for (int64_t r = row - 1; r <= row + 1; ++r) {
+    for (int64_t c = column - 1; c <= column + 1; ++c) {
+      auto cell = cells_.find(cellKey(r, c));
+      if (cell == cells_.end()) continue;
+
+      for (uint32_t i: cell->second) {
+        const Coordinates &point = points_[i];
+        if (std::abs(point.lat - location.lat) + std::abs(point.lon - location.lon) <= radius)
+          found.push_back(i);
+      }
+    }
+  }
+
+  return found;
+}
+
+int64_t SpatialGrid::cellKey(int64_t row, int64_t column) {
+  // Rows and columns of valid coordinates fit comfortably in 32 bits each
+  return (row << 32) ^ (column & 0xFFFFFFFF);
+}
+
+int64_t SpatialGrid::cellIndex(double degrees) const {
+  return static_cast<int64_t>(std::floor(degrees / cell_size_));
+}
@@ -0,0 +1,70 @@
+/**
+ * @file SpatialGrid.h
+ * @brief Defines the SpatialGrid class, a uniform grid index over geographical points.
+ *
+ * This header file declares the SpatialGrid class, which buckets points by latitude and longitude
+ * so that the points near a location can be found without comparing it to every other point.
+ */
+
+#ifndef RAPTOR_SPATIALGRID_H
+#define RAPTOR_SPATIALGRID_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+/**
+ * @struct Coordinates
+ * @brief Latitude and longitude of a point, in decimal degrees.
+ */
+struct Coordinates {
+  double lat; ///< Latitude in decimal degrees.
+  double lon; ///< Longitude in decimal degrees.
+};
+
+/**
+ * @class SpatialGrid
+ * @brief Uniform grid of square cells over latitude and longitude.
+ *
+ * With cells as large as the search radius, every point within the radius of a location
+ * lies in the location's cell or in one of its 8 neighbours.
+ */
+class SpatialGrid {
+public:
+  /**
+   * @brief Buckets points into the cells of the grid.
+   * @param[in] points The coordinates of the points. Points are identified by their index.
+   * @param[in] cell_size The side of a cell, in decimal degrees. Must be positive.
+   */
+  SpatialGrid(std::vector<Coordinates> points, double cell_size);
+
+  /**
+   * @brief Finds the points within a Manhattan distance of a location.
+   * @param[in] location The coordinates of the location.
+   * @param[in] radius The maximum Manhattan distance, in decimal degrees. Must not exceed the cell size.
+   * @return The indices of the points within the radius, in no particular order.
+   */
+  std::vector<uint32_t> findWithin(const Coordinates &location, double radius) const;
+
+private:
+  std::vector<Coordinates> points_; ///< Coordinates of each point.
+  double cell_size_; ///< Side of a cell, in decimal degrees.
+  std::unordered_map<int64_t, std::vector<uint32_t>> cells_; ///< Indices of the points in each non-empty cell.
+
+  /**
+   * @brief Computes the key of the cell at given grid coordinates.
+   * @param[in] row The row of the cell, along the latitude.
+   * @param[in] column The column of the cell, along the longitude.
+   * @return The cell key.
+   */
+  static int64_t cellKey(int64_t row, int64_t column);
+
+  /**
+   * @brief Computes the row or column of a coordinate.
+   * @param[in] degrees The latitude or longitude.
+   * @return The row or column containing it.
+   */
+  int64_t cellIndex(double degrees) const;
+};
+
+#endif //RAPTOR_SPATIALGRID_H
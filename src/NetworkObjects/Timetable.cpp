@@ -0,0 +1,595 @@
+/**
+ * @file Timetable.cpp
+ * @brief Timetable class implementation
+ *
+ * This file contains the implementation of the Timetable class, which compiles
+ * the parsed GTFS data into dense arrays for the RAPTOR algorithm, and saves and
+ * memory-maps them as binary snapshots.
+ */
+
+#include "Timetable.h"
+#include "../Utils.h"
+
+#include <map>
+#include <numeric> // for iota
+#include <fstream>
+#include <cstring>
+#include <fcntl.h>    // for open
+#include <sys/mman.h> // for mmap
+#include <sys/stat.h> // for fstat
+#include <unistd.h>   // for close
+
+/**
+ * @brief Magic bytes at the start of every snapshot.
+ */
+static constexpr char SNAPSHOT_MAGIC[8] = {'R', 'A', 'P', 'T', 'O', 'R', 'T', 'T'};
+
+/**
+ * @struct SnapshotHeader
+ * @brief Header of a binary snapshot, followed by one SnapshotSection per column.
+ */
+struct SnapshotHeader {
+  char magic[8];         ///< Must be SNAPSHOT_MAGIC.
+  uint32_t version;      ///< Must be SNAPSHOT_VERSION.
+  uint32_t num_sections; ///< Number of columns.
+  uint64_t checksum;     ///< Checksum of every byte after the header.
+  uint64_t size;         ///< Total size of the snapshot in bytes.
+};
+
+/**
+ * @struct SnapshotSection
+ * @brief Location of a column in a binary snapshot.
+ */
+struct SnapshotSection {
+  uint64_t offset; ///< Offset of the column from the start of the snapshot, aligned to 8 bytes.
+  uint64_t count;  ///< Number of elements in the column.
+};
+
+/**
+ * @brief Computes a 64-bit FNV-1a style checksum, one 8-byte word at a time.
+ * @param[in] data The bytes to checksum.
+ * @param[in] size The number of bytes.
+ * @return The checksum.
+ */
+static uint64_t checksum(const char *data, size_t size) {
+  uint64_t hash = 14695981039346656037ULL;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * 1099511628211ULL;
+  }
+  for (; i < size; ++i)
+    hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+  return hash;
+}
+
+/**
+ * @brief Flattens strings into the offsets and characters of a StringTable.
+ * @param[in] strings The strings to flatten.
+ * @param[out] offsets The offset of each string, plus a final sentinel.
+ * @param[out] chars The concatenated characters.
+ */
+static void flatten(const std::vector<std::string> &strings, std::vector<uint32_t> &offsets, std::vector<char> &chars) {
+  offsets.reserve(strings.size() + 1);
+  for (const auto &str: strings) {
+    offsets.push_back(chars.size());
+    chars.insert(chars.end(), str.begin(), str.end());
+  }
+  offsets.push_back(chars.size());
+}
+
+template<typename T, typename F>
+void Timetable::forEachColumn(T &timetable, F &&function) {
+  function(timetable.routes_);
+  function(timetable.route_stops_);
+  function(timetable.stop_events_);
+  function(timetable.departures_);
+  function(timetable.stop_routes_offsets_);
+  function(timetable.stop_routes_);
+  function(timetable.footpaths_offsets_);
+  function(timetable.footpaths_);
+  function(timetable.min_change_times_);
+  function(timetable.stop_zones_);
+  function(timetable.trip_routes_);
+  function(timetable.trip_services_);
+  function(timetable.service_period_);
+  function(timetable.service_days_);
+  function(timetable.stop_ids_.offsets);
+  function(timetable.stop_ids_.chars);
+  function(timetable.stop_names_.offsets);
+  function(timetable.stop_names_.chars);
+  function(timetable.trip_ids_.offsets);
+  function(timetable.trip_ids_.chars);
+  function(timetable.agency_names_.offsets);
+  function(timetable.agency_names_.chars);
+}
+
+Timetable::Timetable(const GTFSFeed &feed, const std::vector<std::vector<Footpath>> &stop_footpaths) {
+  std::vector<RouteInfo> route_infos;
+  std::vector<StopId> route_stops;
+  std::vector<StopEvent> stop_events;
+  std::vector<int> departures;
+  std::vector<uint32_t> stop_routes_offsets;
+  std::vector<RoutePosition> stop_routes;
+  std::vector<uint32_t> footpaths_offsets;
+  std::vector<Footpath> footpaths;
+  std::vector<int> min_change_times;
+  std::vector<uint32_t> stop_zones;
+  std::vector<RouteId> trip_routes;
+  std::vector<ServiceId> trip_services;
+  std::vector<ServicePeriod> service_period;
+  std::vector<uint64_t> service_days;
+  std::vector<std::string> stop_ids, stop_names, trip_ids, agency_names;
+
+  // Interning is over, so IDs are read from a view rather than through the interner's lock
+  const std::vector<std::string_view> strings = feed.strings->view();
+
+  // Returns the rows of a table, sorted by ID
+  auto sortedRows = [&](const std::vector<StringId> &ids) {
+    std::vector<uint32_t> rows(ids.size());
+    std::iota(rows.begin(), rows.end(), 0);
+    std::sort(rows.begin(), rows.end(), [&](uint32_t a, uint32_t b) { return strings[ids[a]] < strings[ids[b]]; });
+    return rows;
+  };
+
+  // Number stops by ID, so that indices do not depend on file order and IDs can be binary searched
+  std::vector<uint32_t> stop_rows = sortedRows(feed.stops.stop_id);
+  std::vector<StopId> stop_index(stop_rows.size());
+  stop_ids.reserve(stop_rows.size());
+  stop_names.reserve(stop_rows.size());
+  for (StopId s = 0; s < stop_rows.size(); ++s) {
+    stop_index[stop_rows[s]] = s;
+    stop_ids.emplace_back(strings[feed.stops.stop_id[stop_rows[s]]]);
+    stop_names.push_back(feed.stops.stop_name[stop_rows[s]]);
+  }
+
+  // Zones are numbered in order of first appearance, which is the same in every feed sharing them
+  std::map<std::string_view, uint32_t> zone_index;
+  const std::vector<std::string> &stop_columns = feed.stops.extra.getNames();
+  size_t zone_column = std::find(stop_columns.begin(), stop_columns.end(), "zone_id") - stop_columns.begin();
+  stop_zones.reserve(stop_rows.size());
+  for (uint32_t row: stop_rows) {
+    std::string_view zone = zone_column < stop_columns.size() ? feed.stops.extra.get(zone_column, row) : "";
+    if (zone.empty()) stop_zones.push_back(NO_ZONE);
+    else stop_zones.push_back(zone_index.emplace(zone, zone_index.size()).first->second);
+  }
+
+  std::vector<AgencyId> agency_index(feed.agencies.size());
+  for (uint32_t row: sortedRows(feed.agencies.agency_id)) {
+    agency_index[row] = agency_names.size();
+    agency_names.push_back(feed.agencies.agency_name[row]);
+  }
+
+  // Days since 1970-01-01 of a YYYYMMDD date
+  auto toDays = [](int yyyymmdd) {
+    return Utils::daysSinceEpoch(yyyymmdd / 10000, yyyymmdd / 100 % 100, yyyymmdd % 100);
+  };
+
+  // The service period spans every date of the calendars and of their exceptions
+  int first_day = std::numeric_limits<int>::max(), last_day = std::numeric_limits<int>::min();
+  for (uint32_t row = 0; row < feed.calendars.size(); ++row) {
+    first_day = std::min(first_day, toDays(feed.calendars.start_date[row]));
+    last_day = std::max(last_day, toDays(feed.calendars.end_date[row]));
+  }
+  for (int date: feed.calendar_dates.date) {
+    first_day = std::min(first_day, toDays(date));
+    last_day = std::max(last_day, toDays(date));
+  }
+  if (first_day > last_day) first_day = last_day = 0;
+
+  // Times past 24:00:00 are on the days after their service day
+  int latest_departure = 0;
+  for (int departure: feed.stop_times.departure_seconds)
+    latest_departure = std::max(latest_departure, departure);
+
+  service_period.push_back({first_day, static_cast<uint32_t>(last_day - first_day + 1),
+                            static_cast<uint32_t>(latest_departure / MIDNIGHT)});
+  size_t service_words = (service_period.front().num_days + 63) / 64;
+
+  // Compile each calendar into one bit per day of the period, then apply its exceptions
+  std::vector<ServiceId> service_index(feed.calendars.size());
+  std::vector<uint32_t> service_rows = sortedRows(feed.calendars.service_id);
+  service_days.assign(service_rows.size() * service_words, 0);
+  for (ServiceId service = 0; service < service_rows.size(); ++service) {
+    uint32_t row = service_rows[service];
+    service_index[row] = service;
+
+    uint64_t *words = service_days.data() + service * service_words;
+    for (int day = toDays(feed.calendars.start_date[row]); day <= toDays(feed.calendars.end_date[row]); ++day) {
+      int weekday = (day % 7 + 11) % 7; // 1970-01-01 was a Thursday
+      if (feed.calendars.weekdays[row] >> weekday & 1)
+        words[(day - first_day) / 64] |= uint64_t{1} << (day - first_day) % 64;
+    }
+  }
+
+  for (uint32_t row = 0; row < feed.calendar_dates.size(); ++row) {
+    int day = toDays(feed.calendar_dates.date[row]) - first_day;
+    uint64_t &word = service_days[service_index[feed.calendar_dates.service[row]] * service_words + day / 64];
+    if (feed.calendar_dates.exception_type[row] == 1) word |= uint64_t{1} << day % 64;
+    else word &= ~(uint64_t{1} << day % 64);
+  }
+
+  // Group trips by (route_id, direction_id) and by the exact sequence of stops they visit
+  // ((route_id, direction_id), stop sequence) -> trip rows
+  std::map<std::pair<std::pair<std::string_view, uint8_t>, std::vector<StopId>>, std::vector<uint32_t>> patterns;
+  for (uint32_t trip = 0; trip < feed.trips.size(); ++trip) {
+    std::span<const uint32_t> trip_stop_times = feed.getTripStopTimes(trip);
+    if (trip_stop_times.empty()) continue;
+
+    std::vector<StopId> sequence;
+    sequence.reserve(trip_stop_times.size());
+    for (uint32_t stop_time: trip_stop_times)
+      sequence.push_back(stop_index[feed.stop_times.stop[stop_time]]);
+
+    uint32_t route = feed.trips.route[trip];
+    patterns[{{strings[feed.routes.route_id[route]], feed.trips.direction_id[trip]}, std::move(sequence)}].push_back(trip);
+  }
+
+  route_infos.reserve(patterns.size());
+  trip_ids.reserve(feed.trips.size());
+  stop_events.reserve(feed.stop_times.size());
+
+  for (auto &[pattern, pattern_trips]: patterns) {
+    const std::vector<StopId> &sequence = pattern.second;
+    AgencyId agency = agency_index[feed.routes.agency[feed.trips.route[pattern_trips.front()]]];
+
+    // Sort the pattern's trips by departure from the first stop
+    auto first_departure = [&](uint32_t trip) {
+      return feed.stop_times.departure_seconds[feed.getTripStopTimes(trip).front()];
+    };
+    std::sort(pattern_trips.begin(), pattern_trips.end(), [&](uint32_t a, uint32_t b) {
+      int departureA = first_departure(a);
+      int departureB = first_departure(b);
+      return departureA < departureB
+             || (departureA == departureB && strings[feed.trips.trip_id[a]] < strings[feed.trips.trip_id[b]]);
+    });
+
+    // A trip overtakes another if it leaves or arrives at any stop earlier
+    auto overtakes = [&](uint32_t trip, uint32_t previous) {
+      std::span<const uint32_t> trip_stop_times = feed.getTripStopTimes(trip);
+      std::span<const uint32_t> previous_stop_times = feed.getTripStopTimes(previous);
+      for (size_t s = 0; s < trip_stop_times.size(); ++s)
+        if (feed.stop_times.departure_seconds[trip_stop_times[s]]
+            < feed.stop_times.departure_seconds[previous_stop_times[s]]
+            || feed.stop_times.arrival_seconds[trip_stop_times[s]]
+               < feed.stop_times.arrival_seconds[previous_stop_times[s]])
+          return true;
+      return false;
+    };
+
+    // Split the pattern into routes whose trips do not overtake each other, so that their departures
+    // are sorted at every stop: each trip joins the first route whose last trip it does not overtake
+    std::vector<std::vector<uint32_t>> pattern_routes;
+    for (uint32_t trip: pattern_trips) {
+      auto route = std::find_if(pattern_routes.begin(), pattern_routes.end(),
+                                [&](const std::vector<uint32_t> &route_trips) {
+                                  return !overtakes(trip, route_trips.back());
+                                });
+      if (route != pattern_routes.end()) route->push_back(trip);
+      else pattern_routes.push_back({trip});
+    }
+
+    for (const std::vector<uint32_t> &route_trips: pattern_routes) {
+      auto route_id = static_cast<RouteId>(route_infos.size());
+
+      route_infos.push_back({static_cast<uint32_t>(route_stops.size()), static_cast<uint32_t>(sequence.size()),
+                             static_cast<TripId>(trip_ids.size()), static_cast<uint32_t>(route_trips.size()),
+                             static_cast<uint32_t>(stop_events.size()), agency});
+
+      route_stops.insert(route_stops.end(), sequence.begin(), sequence.end());
+
+      for (uint32_t trip: route_trips) {
+        trip_ids.emplace_back(strings[feed.trips.trip_id[trip]]);
+        trip_routes.push_back(route_id);
+        trip_services.push_back(service_index[feed.trips.service[trip]]);
+
+        for (uint32_t stop_time: feed.getTripStopTimes(trip))
+          stop_events.push_back({feed.stop_times.arrival_seconds[stop_time],
+                                 feed.stop_times.departure_seconds[stop_time]});
+      }
+    }
+  }
+
+  // Transpose each route's stop events into per-stop departure columns
+  departures.resize(stop_events.size());
+  for (const RouteInfo &route: route_infos)
+    for (uint32_t t = 0; t < route.num_trips; ++t)
+      for (uint32_t s = 0; s < route.num_stops; ++s)
+        departures[route.first_stop_event + s * route.num_trips + t] =
+                stop_events[route.first_stop_event + t * route.num_stops + s].departure_seconds;
+
+  // Associate routes to stops, with the position of every visit
+  std::vector<std::vector<RoutePosition>> routes_per_stop(stop_ids.size());
+  for (RouteId r = 0; r < route_infos.size(); ++r)
+    for (uint32_t s = 0; s < route_infos[r].num_stops; ++s)
+      routes_per_stop[route_stops[route_infos[r].first_stop + s]].push_back({r, s});
+
+  stop_routes_offsets.reserve(stop_ids.size() + 1);
+  for (const auto &stop_route_ids: routes_per_stop) {
+    stop_routes_offsets.push_back(stop_routes.size());
+    stop_routes.insert(stop_routes.end(), stop_route_ids.begin(), stop_route_ids.end());
+  }
+  stop_routes_offsets.push_back(stop_routes.size());
+
+  std::vector<std::vector<Footpath>> transfers(stop_ids.size());
+  for (StopId s = 0; s < stop_rows.size(); ++s)
+    for (const auto &[to, duration]: stop_footpaths[stop_rows[s]])
+      transfers[s].push_back({stop_index[to], duration});
+
+  // Transfers of the feed from a stop to itself set its change time, the others are footpaths already
+  min_change_times.assign(stop_ids.size(), 0);
+  for (uint32_t row = 0; row < feed.transfers.size(); ++row) {
+    uint32_t from_row = feed.transfers.from_stop[row];
+    if (from_row != feed.transfers.to_stop[row]) continue;
+
+    uint8_t type = feed.transfers.transfer_type[row];
+    int min_time = feed.transfers.min_transfer_time[row];
+    min_change_times[stop_index[from_row]] = type == 3 ? NO_TRANSFER : (type == 2 ? std::max(min_time, 0) : 0);
+  }
+
+  // Footpaths, sorted by destination
+  footpaths_offsets.reserve(stop_ids.size() + 1);
+  for (std::vector<Footpath> &stop_transfers: transfers) {
+    std::sort(stop_transfers.begin(), stop_transfers.end(),
+              [](const Footpath &a, const Footpath &b) { return a.to < b.to; });
+    footpaths_offsets.push_back(footpaths.size());
+    footpaths.insert(footpaths.end(), stop_transfers.begin(), stop_transfers.end());
+  }
+  footpaths_offsets.push_back(footpaths.size());
+
+  std::vector<uint32_t> stop_ids_offsets, stop_names_offsets, trip_ids_offsets, agency_names_offsets;
+  std::vector<char> stop_ids_chars, stop_names_chars, trip_ids_chars, agency_names_chars;
+  flatten(stop_ids, stop_ids_offsets, stop_ids_chars);
+  flatten(stop_names, stop_names_offsets, stop_names_chars);
+  flatten(trip_ids, trip_ids_offsets, trip_ids_chars);
+  flatten(agency_names, agency_names_offsets, agency_names_chars);
+
+  // Point the columns to the vectors, then lay them out as a snapshot image the timetable owns
+  routes_ = route_infos;
+  route_stops_ = route_stops;
+  stop_events_ = stop_events;
+  departures_ = departures;
+  stop_routes_offsets_ = stop_routes_offsets;
+  stop_routes_ = stop_routes;
+  footpaths_offsets_ = footpaths_offsets;
+  footpaths_ = footpaths;
+  min_change_times_ = min_change_times;
+  stop_zones_ = stop_zones;
+  trip_routes_ = trip_routes;
+  trip_services_ = trip_services;
+  service_period_ = service_period;
+  service_days_ = service_days;
+  stop_ids_ = {stop_ids_offsets, stop_ids_chars};
+  stop_names_ = {stop_names_offsets, stop_names_chars};
+  trip_ids_ = {trip_ids_offsets, trip_ids_chars};
+  agency_names_ = {agency_names_offsets, agency_names_chars};
+
+  size_t num_sections = 0;
+  forEachColumn(*this, [&](const auto &) { ++num_sections; });
+
+  std::vector<SnapshotSection> sections;
+  size_t size = sizeof(SnapshotHeader) + num_sections * sizeof(SnapshotSection);
+  forEachColumn(*this, [&](const auto &column) {
+    size = (size + 7) & ~size_t{7};
+    sections.push_back({size, column.size()});
+    size += column.size_bytes();
+  });
+
+  // 8-byte words, so that every column is suitably aligned
+  auto image = std::make_shared<std::vector<uint64_t>>((size + 7) / 8);
+  char *data = reinterpret_cast<char *>(image->data());
+
+  size_t section = 0;
+  forEachColumn(*this, [&](const auto &column) {
+    if (!column.empty())
+      std::memcpy(data + sections[section].offset, column.data(), column.size_bytes());
+    ++section;
+  });
+  std::memcpy(data + sizeof(SnapshotHeader), sections.data(), sections.size() * sizeof(SnapshotSection));
+
+  SnapshotHeader header{};
+  std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  header.version = SNAPSHOT_VERSION;
+  header.num_sections = num_sections;
+  header.checksum = checksum(data + sizeof(SnapshotHeader), size - sizeof(SnapshotHeader));
+  header.size = size;
+  std::memcpy(data, &header, sizeof(header));
+
+  attach(data, size);
+  storage_ = std::move(image);
+}
+
+Timetable Timetable::load(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Could not open " + path);
+
+  struct stat file_stat{};
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(SnapshotHeader))) {
+    close(fd);
+    throw std::runtime_error(path + " is not a timetable snapshot");
+  }
+
+  auto size = static_cast<size_t>(file_stat.st_size);
+  void *address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd); // The mapping stays valid after closing the file
+  if (address == MAP_FAILED)
+    throw std::runtime_error("Could not map " + path);
+
+  Timetable timetable;
+  timetable.storage_ = std::shared_ptr<const void>(address, [size](const void *mapped) {
+    munmap(const_cast<void *>(mapped), size);
+  });
+  timetable.attach(static_cast<const char *>(address), size);
+
+  return timetable;
+}
+
+void Timetable::save(const std::string &path) const {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+  if (!file.is_open())
+    throw std::runtime_error("Could not open " + path);
+
+  file.write(image_.data(), static_cast<std::streamsize>(image_.size()));
+
+  if (!file)
+    throw std::runtime_error("Could not write " + path);
+}
+
+void Timetable::attach(const char *data, size_t size) {
+  SnapshotHeader header{};
+  std::memcpy(&header, data, sizeof(header));
+
+  if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+    throw std::runtime_error("Not a timetable snapshot");
+
+  if (header.version != SNAPSHOT_VERSION)
+    throw std::runtime_error("Unsupported snapshot version " + std::to_string(header.version)
+                             + " (expected " + std::to_string(SNAPSHOT_VERSION) + ")");
+
+  size_t num_sections = 0;
+  forEachColumn(*this, [&](const auto &) { ++num_sections; });
+
+  if (header.size != size || header.num_sections != num_sections
+      || sizeof(SnapshotHeader) + num_sections * sizeof(SnapshotSection) > size)
+    throw std::runtime_error("Truncated or malformed snapshot");
+
+  // Only the header and the section table are read, so that loading does not touch every page of the image
+  const auto *sections = reinterpret_cast<const SnapshotSection *>(data + sizeof(SnapshotHeader));
+  size_t section = 0;
+  forEachColumn(*this, [&](auto &column) {
+    using Element = typename std::remove_reference_t<decltype(column)>::element_type;
+    const SnapshotSection &location = sections[section++];
+
+    if (location.offset % alignof(Element) != 0 || location.offset > size
+        || location.count > (size - location.offset) / sizeof(Element))
+      throw std::runtime_error("Truncated or malformed snapshot");
+
+    column = {reinterpret_cast<Element *>(data + location.offset), location.count};
+  });
+
+  if (service_period_.size() != 1)
+    throw std::runtime_error("Truncated or malformed snapshot");
+  service_words_ = (service_period_.front().num_days + 63) / 64;
+
+  image_ = {data, size};
+}
+
+void Timetable::verify() const {
+  SnapshotHeader header{};
+  std::memcpy(&header, image_.data(), sizeof(header));
+
+  if (header.checksum != checksum(image_.data() + sizeof(SnapshotHeader), image_.size() - sizeof(SnapshotHeader)))
+    throw std::runtime_error("Snapshot checksum mismatch");
+}
+
+size_t Timetable::numStops() const {
+  return stop_ids_.size();
+}
+
+size_t Timetable::numRoutes() const {
+  return routes_.size();
+}
+
+size_t Timetable::numTrips() const {
+  return trip_ids_.size();
+}
+
+size_t Timetable::numStopEvents() const {
+  return stop_events_.size();
+}
+
+const RouteInfo &Timetable::getRoute(RouteId route) const {
+  return routes_[route];
+}
+
+std::span<const StopId> Timetable::getRouteStops(RouteId route) const {
+  const RouteInfo &info = routes_[route];
+  return route_stops_.subspan(info.first_stop, info.num_stops);
+}
+
+std::span<const StopEvent> Timetable::getTripStopEvents(TripId trip) const {
+  const RouteInfo &info = routes_[trip_routes_[trip]];
+  return stop_events_.subspan(info.first_stop_event + (trip - info.first_trip) * info.num_stops, info.num_stops);
+}
+
+std::span<const int> Timetable::getDepartures(RouteId route, uint32_t position) const {
+  const RouteInfo &info = routes_[route];
+  return departures_.subspan(info.first_stop_event + position * info.num_trips, info.num_trips);
+}
+
+std::span<const RoutePosition> Timetable::getStopRoutes(StopId stop) const {
+  return stop_routes_.subspan(stop_routes_offsets_[stop], stop_routes_offsets_[stop + 1] - stop_routes_offsets_[stop]);
+}
+
+std::span<const Footpath> Timetable::getFootpaths(StopId stop) const {
+  return footpaths_.subspan(footpaths_offsets_[stop], footpaths_offsets_[stop + 1] - footpaths_offsets_[stop]);
+}
+
+int Timetable::getMinChangeTime(StopId stop) const {
+  return min_change_times_[stop];
+}
+
+uint32_t Timetable::getStopZone(StopId stop) const {
+  return stop_zones_[stop];
+}
+
+RouteId Timetable::getTripRoute(TripId trip) const {
+  return trip_routes_[trip];
+}
+
+std::optional<uint32_t> Timetable::findServiceDay(const Date &date) const {
+  const ServicePeriod &period = service_period_.front();
+  int day = Utils::daysSinceEpoch(date.year, date.month, date.day) - period.first_day;
+
+  if (day < 0 || static_cast<uint32_t>(day) >= period.num_days) return std::nullopt;
+  return static_cast<uint32_t>(day);
+}
+
+uint32_t Timetable::numOvernightDays() const {
+  return service_period_.front().overnight_days;
+}
+
+bool Timetable::isTripActive(TripId trip, uint32_t service_day) const {
+  return service_days_[trip_services_[trip] * service_words_ + service_day / 64] >> (service_day % 64) & 1;
+}
+
+bool Timetable::isTripActive(TripId trip, const Date &date) const {
+  std::optional<uint32_t> service_day = findServiceDay(date);
+  return service_day.has_value() && isTripActive(trip, service_day.value());
+}
+
+std::optional<StopId> Timetable::findStop(const std::string &stop_id) const {
+  // Stop IDs are sorted, so binary search them
+  size_t low = 0, high = stop_ids_.size();
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (stop_ids_[middle] < stop_id) low = middle + 1;
+    else high = middle;
+  }
+
+  if (low == stop_ids_.size() || stop_ids_[low] != stop_id) return std::nullopt;
+  return static_cast<StopId>(low);
+}
+
+std::string_view Timetable::getStopId(StopId stop) const {
+  return stop_ids_[stop];
+}
+
+std::string_view Timetable::getStopName(StopId stop) const {
+  return stop_names_[stop];
+}
+
+std::string_view Timetable::getTripId(TripId trip) const {
+  return trip_ids_[trip];
+}
+
+AgencyId Timetable::getTripAgency(TripId trip) const {
+  return routes_[trip_routes_[trip]].agency;
+}
+
+std::string_view Timetable::getAgencyName(AgencyId agency) const {
+  return agency_names_[agency];
+}
@@ -0,0 +1,387 @@
+/**
+ * @file Timetable.h
+ * @brief Defines the Timetable class, a dense integer-indexed view of the transit network.
+ *
+ * This header file declares the Timetable class, which compiles the parsed GTFS tables
+ * into the flat arrays used by the RAPTOR rounds: contiguous stop, route and trip indices,
+ * route-major stop events and the routes serving each stop.
+ * String IDs are only kept in side tables, for input and output.
+ *
+ * A compiled timetable can be saved to a binary snapshot and memory-mapped back,
+ * without parsing the GTFS files again.
+ */
+
+#ifndef RAPTOR_TIMETABLE_H
+#define RAPTOR_TIMETABLE_H
+
+#include <span>
+#include <memory>
+#include <string_view>
+
+#include "DataStructures.h"
+#include "GTFSFeed.h"
+
+/**
+ * @struct StopEvent
+ * @brief Arrival and departure of a trip at one stop of its route.
+ */
+struct StopEvent {
+  int arrival_seconds;   ///< Arrival time in seconds from midnight of the service day.
+  int departure_seconds; ///< Departure time in seconds from midnight of the service day.
+};
+
+/**
+ * @struct RouteInfo
+ * @brief Offsets of a route into the Timetable arrays.
+ *
+ * A route groups the trips of a GTFS (route_id, direction_id) that visit exactly the same
+ * sequence of stops, so its stop events form a dense trips x stops matrix. No trip of a route
+ * overtakes another, so its departures are sorted at every stop.
+ */
+struct RouteInfo {
+  uint32_t first_stop;       ///< Offset of the route's first stop in the route stops array.
+  uint32_t num_stops;        ///< Number of stops visited by every trip of the route.
+  TripId first_trip;         ///< Index of the route's first trip. Trips of a route are contiguous.
+  uint32_t num_trips;        ///< Number of trips of the route.
+  uint32_t first_stop_event; ///< Offset of the route's trip-major block in the stop events array,
+                             ///< and of its stop-major block in the departures array.
+  AgencyId agency;           ///< Index of the agency operating the route.
+};
+
+/**
+ * @struct RoutePosition
+ * @brief Visit of a route to a stop.
+ */
+struct RoutePosition {
+  RouteId route;     ///< Index of the route.
+  uint32_t position; ///< Position of the stop in the route.
+};
+
+/**
+ * @struct Footpath
+ * @brief Walking connection from a stop to another stop.
+ */
+struct Footpath {
+  StopId to;    ///< Index of the destination stop.
+  int duration; ///< Walking duration in seconds.
+};
+
+/**
+ * @struct ServicePeriod
+ * @brief Dates covered by the service calendars of a timetable.
+ */
+struct ServicePeriod {
+  int first_day;     ///< First date of any service, in days since 1970-01-01.
+  uint32_t num_days; ///< Number of days from the first to the last date of any service.
+  uint32_t overnight_days; ///< Number of days after its service day that a trip may still depart, for times past 24:00.
+};
+
+/**
+ * @struct StringTable
+ * @brief Flat table of strings, stored as concatenated characters and offsets.
+ */
+struct StringTable {
+  std::span<const uint32_t> offsets; ///< Offset of each string in chars, plus a final sentinel.
+  std::span<const char> chars;       ///< Concatenated characters of all strings.
+
+  /**
+   * @brief Gets the number of strings in the table.
+   * @return The number of strings.
+   */
+  size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+  /**
+   * @brief Gets a string of the table.
+   * @param[in] i The index of the string.
+   * @return A view over the string's characters.
+   */
+  std::string_view operator[](size_t i) const { return {chars.data() + offsets[i], offsets[i + 1] - offsets[i]}; }
+};
+
+/**
+ * @brief Version of the binary snapshot format. Must be bumped whenever a column changes.
+ */
+static constexpr uint32_t SNAPSHOT_VERSION = 7;
+
+/**
+ * @brief Minimum change time of stops where vehicles cannot be changed.
+ */
+static constexpr int NO_TRANSFER = UNREACHED;
+
+/**
+ * @brief Fare zone of stops without a zone_id.
+ */
+static constexpr uint32_t NO_ZONE = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @class Timetable
+ * @brief Dense, integer-indexed representation of a transit network.
+ *
+ * Stops, routes and trips are identified by contiguous indices. Variable-length relations
+ * (stops of a route, routes serving a stop, footpaths of a stop) are stored as offset arrays
+ * into flat vectors, and the stop events of each route are stored trip-major, with trips sorted
+ * by departure from the first stop. Departures are also stored stop-major, so that the trips
+ * of a route can be binary searched at any of its stops.
+ *
+ * Columns are read-only views into a snapshot image, either built in memory by the timetable
+ * or memory-mapped from a file, so copies of a timetable are cheap and share the same data.
+ */
+class Timetable {
+public:
+  /**
+   * @brief Default constructor, creating an empty timetable.
+   */
+  Timetable() = default;
+
+  /**
+   * @brief Compiles a timetable from the tables of a GTFS feed.
+   *
+   * Trips are grouped into routes by (route_id, direction_id) and stop sequence, and the trips of a group
+   * that overtake each other are split into separate routes. Service calendars, with their calendar_dates
+   * exceptions, are compiled into one bit per day of the service period.
+   *
+   * @param[in] feed The feed, with stop times grouped by trip.
+   * @param[in] stop_footpaths The footpaths from each stop row of the feed, to stop rows of the feed, with the
+   *            transfers of the feed between different stops applied. Transfers from a stop to itself set its
+   *            change time.
+   */
+  Timetable(const GTFSFeed &feed, const std::vector<std::vector<Footpath>> &stop_footpaths);
+
+  /**
+   * @brief Memory-maps a timetable snapshot.
+   *
+   * The file is mapped read-only and the columns point directly into it, so nothing is parsed
+   * and processes loading the same snapshot share its pages. Only the header and the section table
+   * are checked, so that pages are only read once queries need them: see verify().
+   *
+   * @param[in] path Path to a snapshot written by save().
+   * @return The mapped timetable.
+   * @throws std::runtime_error If the file cannot be mapped, its version does not match, or a section is out of it.
+   */
+  static Timetable load(const std::string &path);
+
+  /**
+   * @brief Checks the checksum of the whole snapshot image, which loading does not.
+   *
+   * Every page of the image is read.
+   *
+   * @throws std::runtime_error If the checksum does not match.
+   */
+  void verify() const;
+
+  /**
+   * @brief Writes the timetable to a binary snapshot.
+   * @param[in] path Path of the snapshot file to write.
+   * @throws std::runtime_error If the file cannot be written.
+   */
+  void save(const std::string &path) const;
+
+  /**
+   * @brief Gets the number of stops.
+   * @return The number of stops.
+   */
+  size_t numStops() const;
+
+  /**
+   * @brief Gets the number of routes.
+   * @return The number of routes.
+   */
+  size_t numRoutes() const;
+
+  /**
+   * @brief Gets the number of trips.
+   * @return The number of trips.
+   */
+  size_t numTrips() const;
+
+  /**
+   * @brief Gets the number of stop events.
+   * @return The number of stop events.
+   */
+  size_t numStopEvents() const;
+
+  /**
+   * @brief Gets the offsets of a route.
+   * @param[in] route The route index.
+   * @return A constant reference to the route's RouteInfo.
+   */
+  const RouteInfo &getRoute(RouteId route) const;
+
+  /**
+   * @brief Gets the stops visited by a route, in sequence order.
+   * @param[in] route The route index.
+   * @return A view over the route's stop indices.
+   */
+  std::span<const StopId> getRouteStops(RouteId route) const;
+
+  /**
+   * @brief Gets the stop events of a trip, in sequence order.
+   * @param[in] trip The trip index.
+   * @return A view over the trip's stop events, aligned with its route's stops.
+   */
+  std::span<const StopEvent> getTripStopEvents(TripId trip) const;
+
+  /**
+   * @brief Gets the departures of all trips of a route at one of its stops.
+   * @param[in] route The route index.
+   * @param[in] position The position of the stop in the route.
+   * @return A view over the departure times, in trip order, which is also departure order.
+   */
+  std::span<const int> getDepartures(RouteId route, uint32_t position) const;
+
+  /**
+   * @brief Gets the routes serving a stop, with the position of the stop in each.
+   *
+   * A route visiting the stop more than once is listed once per visit, in sequence order.
+   *
+   * @param[in] stop The stop index.
+   * @return A view over the visits of routes to the stop, by route.
+   */
+  std::span<const RoutePosition> getStopRoutes(StopId stop) const;
+
+  /**
+   * @brief Gets the footpaths leaving a stop.
+   * @param[in] stop The stop index.
+   * @return A view over the stop's footpaths.
+   */
+  std::span<const Footpath> getFootpaths(StopId stop) const;
+
+  /**
+   * @brief Gets the time needed to change vehicles at a stop.
+   * @param[in] stop The stop index.
+   * @return The minimum change time in seconds, 0 by default, or `NO_TRANSFER` if vehicles cannot be changed.
+   */
+  int getMinChangeTime(StopId stop) const;
+
+  /**
+   * @brief Gets the fare zone of a stop.
+   * @param[in] stop The stop index.
+   * @return The index of the stop's zone_id among the zones of the timetable, or `NO_ZONE`.
+   */
+  uint32_t getStopZone(StopId stop) const;
+
+  /**
+   * @brief Gets the route a trip belongs to.
+   * @param[in] trip The trip index.
+   * @return The route index.
+   */
+  RouteId getTripRoute(TripId trip) const;
+
+  /**
+   * @brief Looks up a date in the service period.
+   * @param[in] date The date.
+   * @return The number of days from the start of the service period to the date,
+   *         or `std::nullopt` if no service runs on the date.
+   */
+  std::optional<uint32_t> findServiceDay(const Date &date) const;
+
+  /**
+   * @brief Gets the number of days after its service day that a trip may still depart.
+   *
+   * Trips of that many days before a date may run on the date, since GTFS times may go past 24:00:00.
+   *
+   * @return The number of days.
+   */
+  uint32_t numOvernightDays() const;
+
+  /**
+   * @brief Checks if a trip's service runs on a day of the service period.
+   * @param[in] trip The trip index.
+   * @param[in] service_day The day, as returned by findServiceDay().
+   * @return True if the trip's service is active on the day, false otherwise.
+   */
+  bool isTripActive(TripId trip, uint32_t service_day) const;
+
+  /**
+   * @brief Checks if a trip's service runs on a given date.
+   * @param[in] trip The trip index.
+   * @param[in] date The date to check.
+   * @return True if the trip's service is active on the date, false otherwise.
+   */
+  bool isTripActive(TripId trip, const Date &date) const;
+
+  /**
+   * @brief Looks up the index of a stop.
+   * @param[in] stop_id The GTFS stop ID.
+   * @return The stop index, or `std::nullopt` if the stop is unknown.
+   */
+  std::optional<StopId> findStop(const std::string &stop_id) const;
+
+  /**
+   * @brief Gets the GTFS ID of a stop.
+   * @param[in] stop The stop index.
+   * @return The stop ID.
+   */
+  std::string_view getStopId(StopId stop) const;
+
+  /**
+   * @brief Gets the name of a stop.
+   * @param[in] stop The stop index.
+   * @return The stop name.
+   */
+  std::string_view getStopName(StopId stop) const;
+
+  /**
+   * @brief Gets the GTFS ID of a trip.
+   * @param[in] trip The trip index.
+   * @return The trip ID.
+   */
+  std::string_view getTripId(TripId trip) const;
+
+  /**
+   * @brief Gets the agency operating a trip, through the route of the trip.
+   * @param[in] trip The trip index.
+   * @return The agency index.
+   */
+  AgencyId getTripAgency(TripId trip) const;
+
+  /**
+   * @brief Gets the name of an agency.
+   * @param[in] agency The agency index.
+   * @return The agency name.
+   */
+  std::string_view getAgencyName(AgencyId agency) const;
+
+private:
+  std::span<const RouteInfo> routes_; ///< Offsets of each route.
+  std::span<const StopId> route_stops_; ///< Stops of each route, in sequence order.
+  std::span<const StopEvent> stop_events_; ///< Stop events of each route, trip-major.
+  std::span<const int> departures_; ///< Departure times of each route, stop-major.
+  std::span<const uint32_t> stop_routes_offsets_; ///< Offsets of each stop in stop_routes_, plus a final sentinel.
+  std::span<const RoutePosition> stop_routes_; ///< Visits of routes to each stop.
+  std::span<const uint32_t> footpaths_offsets_; ///< Offsets of each stop in footpaths_, plus a final sentinel.
+  std::span<const Footpath> footpaths_; ///< Footpaths leaving each stop.
+  std::span<const int> min_change_times_; ///< Minimum time to change vehicles at each stop.
+  std::span<const uint32_t> stop_zones_; ///< Fare zone of each stop.
+  std::span<const RouteId> trip_routes_; ///< Route of each trip.
+  std::span<const ServiceId> trip_services_; ///< Service calendar of each trip.
+  std::span<const ServicePeriod> service_period_; ///< Dates covered by the services, as a single element.
+  std::span<const uint64_t> service_days_; ///< Bit d of each service's words is set if it runs on day d of the period.
+  uint32_t service_words_ = 0; ///< Number of words per service in service_days_.
+
+  StringTable stop_ids_; ///< Side table of GTFS stop IDs, sorted.
+  StringTable stop_names_; ///< Side table of stop names.
+  StringTable trip_ids_; ///< Side table of GTFS trip IDs.
+  StringTable agency_names_; ///< Side table of agency names.
+
+  std::span<const char> image_; ///< Snapshot image the columns point into.
+  std::shared_ptr<const void> storage_; ///< Owned buffer or file mapping holding the image.
+
+  /**
+   * @brief Points the columns into a snapshot image.
+   * @param[in] data The start of the image, aligned to 8 bytes.
+   * @param[in] size The size of the image in bytes.
+   * @throws std::runtime_error If the header or the section table are malformed, or the version does not match.
+   */
+  void attach(const char *data, size_t size);
+
+  /**
+   * @brief Applies a function to every column, in snapshot order.
+   * @param[in] timetable The timetable whose columns are visited.
+   * @param[in] function The function to apply to each column.
+   */
+  template<typename T, typename F>
+  static void forEachColumn(T &timetable, F &&function);
+};
+
+#endif //RAPTOR_TIMETABLE_H
@@ -0,0 +1,130 @@
+/**
+ * @file ParetoSet.h
+ * @brief Defines the ParetoSet class, a set of mutually non-dominated elements.
+ *
+ * This header file declares the ParetoSet class, used for the journeys kept by queries
+ * and for the bags of labels of multi-criteria queries.
+ */
+
+#ifndef RAPTOR_PARETOSET_H
+#define RAPTOR_PARETOSET_H
+
+#include <vector>
+#include <algorithm>
+
+/**
+ * @class ParetoSet
+ * @brief A set of elements none of which dominates another, sorted by a primary criterion.
+ *
+ * An element can only be dominated by elements whose key is not greater, and only dominate elements whose
+ * key is not smaller, so an insertion binary searches its position and compares the element to each side once.
+ *
+ * If dominance compares the key and a single other criterion, the elements are sorted the other way by that
+ * criterion: only the element just before a new one can dominate it, and the elements it dominates follow it
+ * contiguously, so an insertion makes O(log n) comparisons, amortised over the elements it removes.
+ *
+ * @tparam T The type of the elements.
+ * @tparam Traits A type with `static auto key(const T &)`, the primary criterion, smaller being better,
+ *         `static bool dominates(const T &, const T &)`, only true if the key of the first element is not greater,
+ *         and `static constexpr bool SKYLINE`, true if dominance compares the key and a single other criterion.
+ */
+template<typename T, typename Traits>
+class ParetoSet {
+public:
+  using const_iterator = typename std::vector<T>::const_iterator; ///< Iterator over the elements, by key.
+
+  /**
+   * @brief Checks if an element is dominated by an element of the set.
+   * @param[in] element The element.
+   * @return True if an element of the set dominates it.
+   */
+  bool isDominated(const T &element) const {
+    auto last = upperBound(element);
+
+    // Of the elements with a key not greater, the closest ones are the best in the other criteria
+    for (auto it = last; it != elements_.begin();) {
+      if (Traits::dominates(*--it, element)) return true;
+      if (Traits::SKYLINE) break;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Adds an element, unless it is dominated, and removes the elements it dominates.
+   *
+   * Elements with the same key are kept in insertion order.
+   *
+   * @param[in] element The element.
+   * @return True if the element was added.
+   */
+  bool insert(T element) {
+    if (isDominated(element)) return false;
+
+    auto first = std::lower_bound(elements_.begin(), elements_.end(), Traits::key(element),
+                                  [](const T &other, const auto &key) { return Traits::key(other) < key; });
+
+    if (Traits::SKYLINE) {
+      auto last = first;
+      while (last != elements_.end() && Traits::dominates(element, *last)) ++last;
+      elements_.erase(first, last);
+    } else {
+      elements_.erase(std::remove_if(first, elements_.end(), [&element](const T &other) {
+        return Traits::dominates(element, other);
+      }), elements_.end());
+    }
+
+    // After the elements with the same key, which it does not dominate
+    elements_.insert(upperBound(element), std::move(element));
+    return true;
+  }
+
+  /**
+   * @brief Empties the set, keeping its storage.
+   */
+  void clear() { elements_.clear(); }
+
+  /**
+   * @brief Gets the number of elements.
+   * @return The number of elements.
+   */
+  size_t size() const { return elements_.size(); }
+
+  /**
+   * @brief Checks if the set is empty.
+   * @return True if the set has no element.
+   */
+  bool empty() const { return elements_.empty(); }
+
+  /**
+   * @brief Gets an iterator to the first element, by key.
+   * @return The iterator.
+   */
+  const_iterator begin() const { return elements_.begin(); }
+
+  /**
+   * @brief Gets an iterator past the last element.
+   * @return The iterator.
+   */
+  const_iterator end() const { return elements_.end(); }
+
+  /**
+   * @brief Moves the elements out of the set, which is left empty.
+   * @return The elements, by key.
+   */
+  std::vector<T> release() { return std::move(elements_); }
+
+private:
+  std::vector<T> elements_; ///< Elements, sorted by key.
+
+  /**
+   * @brief Finds the first element with a greater key than an element.
+   * @param[in] element The element.
+   * @return The iterator to the first element with a greater key, or end().
+   */
+  const_iterator upperBound(const T &element) const {
+    return std::upper_bound(elements_.begin(), elements_.end(), Traits::key(element),
+                            [](const auto &key, const T &other) { return key < Traits::key(other); });
+  }
+};
+
+#endif //RAPTOR_PARETOSET_H
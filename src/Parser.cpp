@@ -8,330 +8,481 @@
 
 #include "Parser.h"
 
-Parser::Parser(std::string directory) : inputDirectory(std::move(directory)) {
-  std::cout << "Parsing GTFS data from " << inputDirectory << "..." << std::endl;
+#include <array>
+#include <numeric> // for iota
+#include <filesystem> // for exists
 
-  parseAgencies();
-  std::cout << agencies_.size() << " agencies, ";
+/**
+ * @brief Looks up a column that a file must have.
+ * @param[in] reader The reader over the file.
+ * @param[in] name The name of the column.
+ * @param[in] file The name of the file, for error messages.
+ * @return The index of the column.
+ * @throws std::runtime_error If the file does not have the column.
+ */
+static size_t requireColumn(const CsvReader &reader, std::string_view name, std::string_view file) {
+  std::optional<size_t> column = reader.findColumn(name);
+  if (!column.has_value())
+    throw std::runtime_error("Missing " + std::string(name) + " in " + std::string(file));
+  return column.value();
+}
 
-  parseCalendars();
-  std::cout << calendars_.size() << " calendars, ";
+/**
+ * @brief Adds the columns of a file that have no typed column to an extra column store.
+ * @param[in] reader The reader over the file.
+ * @param[in] typed The names of the typed columns.
+ * @param[in,out] extra The store of the table.
+ * @return Pairs of the index of each extra column in the store and in the file.
+ */
+static std::vector<std::pair<size_t, size_t>> addExtraColumns(const CsvReader &reader,
+                                                              std::initializer_list<std::string_view> typed,
+                                                              ExtraColumns &extra) {
+  std::vector<std::pair<size_t, size_t>> columns;
+  const std::vector<std::string> &fields = reader.getHeader();
 
-  parseTrips();
-  std::cout << trips_.size() << " trips, ";
+  for (size_t i = 0; i < fields.size(); ++i)
+    if (std::find(typed.begin(), typed.end(), fields[i]) == typed.end())
+      columns.emplace_back(extra.addColumn(fields[i], 0), i);
 
-  parseRoutes();
-  std::cout << routes_.size() << " routes, ";
+  return columns;
+}
 
-  parseStops();
-  std::cout << stops_.size() << " stops and ";
+/**
+ * @brief Appends the extra columns of a row to an extra column store.
+ * @param[in,out] extra The store of the table.
+ * @param[in] columns The columns returned by addExtraColumns().
+ * @param[in] tokens The fields of the row.
+ */
+static void appendExtraColumns(ExtraColumns &extra, const std::vector<std::pair<size_t, size_t>> &columns,
+                               const std::vector<std::string_view> &tokens) {
+  for (const auto &[column, field]: columns)
+    extra.append(column, tokens[field]);
+}
 
-  parseStopTimes();
-  std::cout << stop_times_.size() << " stop times parsed. ";
+/**
+ * @brief Gets an optional field of a row.
+ * @param[in] tokens The fields of the row.
+ * @param[in] column The index of the column, or `std::nullopt` if the file does not have it.
+ * @return The field, or an empty view if the file does not have the column.
+ */
+static std::string_view optionalField(const std::vector<std::string_view> &tokens, std::optional<size_t> column) {
+  return column.has_value() ? tokens[column.value()] : std::string_view();
+}
 
-  associateData();
-  std::cout << "Data associated." << std::endl;
+Parser::Parser(std::string directory, ThreadPool *pool, std::shared_ptr<StringInterner> strings)
+        : inputDirectory(std::move(directory)) {
+  if (strings != nullptr) feed_.strings = std::move(strings);
 
-}
+  std::cout << "Parsing GTFS data from " << inputDirectory << "..." << std::endl;
 
-void Parser::parseAgencies() {
-  std::ifstream file(inputDirectory + "/agency.txt");
+  std::unique_ptr<ThreadPool> local_pool;
+  if (pool == nullptr) {
+    local_pool = std::make_unique<ThreadPool>();
+    pool = local_pool.get();
+  }
 
-  if (!file.is_open())
-    throw std::runtime_error("Could not open agency.txt");
+  // Files that do not reference each other are parsed concurrently
+  std::vector<std::future<void>> files;
+  files.push_back(pool->submit([this]() {
+    parseAgencies();
+    parseRoutes();
+  }));
+  files.push_back(pool->submit([this]() {
+    parseCalendars();
+    parseCalendarDates();
+  }));
+  files.push_back(pool->submit([this]() {
+    parseStops();
+    parseTransfers();
+  }));
+  pool->waitAll(files);
+
+  // Trips reference routes and calendars, and stop times reference trips and stops
+  parseTrips();
+  parseStopTimes(*pool);
 
-  std::string line;
-  std::getline(file, line);
-  Utils::clean(line);
-  std::vector<std::string> fields = Utils::split(line, ',');
+  std::ostringstream summary;
+  summary << feed_.agencies.size() << " agencies, "
+          << feed_.calendars.size() << " calendars, "
+          << feed_.trips.size() << " trips, "
+          << feed_.routes.size() << " routes, "
+          << feed_.stops.size() << " stops and "
+          << feed_.stop_times.size() << " stop times parsed from " << inputDirectory << ". ";
 
-  while (std::getline(file, line)) {
-    Utils::clean(line);
+  feed_.associate(pool);
+  summary << "Data associated.";
 
-    if (line.empty()) continue;
+  std::cout << summary.str() << std::endl;
+}
 
-    std::vector<std::string> tokens = Utils::split(line, ',');
+void Parser::parseAgencies() {
+  CsvReader reader(inputDirectory + "/agency.txt");
+  const std::vector<std::string> &fields = reader.getHeader();
+  std::vector<std::string_view> tokens;
+
+  AgencyTable &agencies = feed_.agencies;
+  std::optional<size_t> id_column = reader.findColumn("agency_id"); // Optional if there is only one agency
+  size_t name_column = requireColumn(reader, "agency_name", "agency.txt");
+  auto extra_columns = addExtraColumns(reader, {"agency_id", "agency_name"}, agencies.extra);
 
+  while (reader.readRow(tokens)) {
     if (tokens.size() != fields.size())
       throw std::runtime_error("Mismatched number of tokens and fields");
 
-    Agency agency;
-
-    for (size_t i = 0; i < fields.size(); ++i)
-      agency.setField(fields[i], tokens[i]);
+    StringId id = feed_.strings->intern(optionalField(tokens, id_column));
+    if (!agency_rows_.try_emplace(id, agencies.size()).second) continue; // Keep the first row of an ID
 
-    agencies_[agency.getField("agency_id")] = agency;
+    agencies.agency_id.push_back(id);
+    agencies.agency_name.emplace_back(tokens[name_column]);
+    appendExtraColumns(agencies.extra, extra_columns, tokens);
   }
 }
 
 void Parser::parseCalendars() {
-  std::ifstream file(inputDirectory + "/calendar.txt");
-  if (!file.is_open())
-    throw std::runtime_error("Could not open calendar.txt");
-
-  std::string line;
-  std::getline(file, line);
-  Utils::clean(line);
-  std::vector<std::string> fields = Utils::split(line, ',');
-
-  while (std::getline(file, line)) {
-    Utils::clean(line);
-
-    if (line.empty()) continue;
-
-    std::vector<std::string> tokens = Utils::split(line, ',');
-
+  CsvReader reader(inputDirectory + "/calendar.txt");
+  const std::vector<std::string> &fields = reader.getHeader();
+  std::vector<std::string_view> tokens;
+
+  CalendarTable &calendars = feed_.calendars;
+  size_t id_column = requireColumn(reader, "service_id", "calendar.txt");
+  size_t start_column = requireColumn(reader, "start_date", "calendar.txt");
+  size_t end_column = requireColumn(reader, "end_date", "calendar.txt");
+  std::array<size_t, 7> weekday_columns{};
+  for (int weekday = 0; weekday < 7; ++weekday)
+    weekday_columns[weekday] = requireColumn(reader, weekdays_names[weekday], "calendar.txt");
+
+  auto extra_columns = addExtraColumns(reader, {"service_id", "start_date", "end_date", "sunday", "monday", "tuesday",
+                                                "wednesday", "thursday", "friday", "saturday"}, calendars.extra);
+
+  while (reader.readRow(tokens)) {
     if (tokens.size() != fields.size())
       throw std::runtime_error("Mismatched number of tokens and fields");
 
-    Calendar calendar;
+    StringId id = feed_.strings->intern(tokens[id_column]);
+    if (!service_rows_.try_emplace(id, calendars.size()).second) continue;
 
-    for (size_t i = 0; i < fields.size(); ++i)
-      calendar.setField(fields[i], tokens[i]);
+    uint8_t weekdays = 0;
+    for (int weekday = 0; weekday < 7; ++weekday)
+      if (Utils::parseInt(tokens[weekday_columns[weekday]]))
+        weekdays |= 1 << weekday;
 
-    calendars_[calendar.getField("service_id")] = calendar;
+    calendars.service_id.push_back(id);
+    calendars.weekdays.push_back(weekdays);
+    calendars.start_date.push_back(Utils::parseDate(tokens[start_column]));
+    calendars.end_date.push_back(Utils::parseDate(tokens[end_column]));
+    appendExtraColumns(calendars.extra, extra_columns, tokens);
   }
 }
 
-void Parser::parseTrips() {
-  std::ifstream file(inputDirectory + "trips.txt");
-
-  if (!file.is_open())
-    throw std::runtime_error("Could not open trips.txt");
+void Parser::parseCalendarDates() {
+  std::string path = inputDirectory + "/calendar_dates.txt";
+  if (!std::filesystem::exists(path)) return; // Optional if every service is in calendar.txt
 
-  std::string line;
-  std::getline(file, line);
-  Utils::clean(line);
-  std::vector<std::string> fields = Utils::split(line, ',');
+  CsvReader reader(path);
+  const std::vector<std::string> &fields = reader.getHeader();
+  std::vector<std::string_view> tokens;
 
-  while (std::getline(file, line)) {
-    Utils::clean(line);
-
-    if (line.empty()) continue;
-
-    std::vector<std::string> tokens = Utils::split(line, ',');
+  CalendarTable &calendars = feed_.calendars;
+  CalendarDateTable &calendar_dates = feed_.calendar_dates;
+  size_t id_column = requireColumn(reader, "service_id", "calendar_dates.txt");
+  size_t date_column = requireColumn(reader, "date", "calendar_dates.txt");
+  size_t type_column = requireColumn(reader, "exception_type", "calendar_dates.txt");
+  auto extra_columns = addExtraColumns(reader, {"service_id", "date", "exception_type"}, calendar_dates.extra);
 
+  while (reader.readRow(tokens)) {
     if (tokens.size() != fields.size())
       throw std::runtime_error("Mismatched number of tokens and fields");
 
-    Trip trip;
-    for (size_t i = 0; i < fields.size(); ++i)
-      trip.setField(fields[i], tokens[i]);
+    int date = Utils::parseDate(tokens[date_column]);
+    int exception_type = Utils::parseInt(tokens[type_column]);
+    if (exception_type != 1 && exception_type != 2)
+      throw std::runtime_error("Invalid exception_type " + std::string(tokens[type_column]) + " in calendar_dates.txt");
+
+    // A service only defined by its exceptions runs on no weekday
+    StringId id = feed_.strings->intern(tokens[id_column]);
+    auto [row, inserted] = service_rows_.try_emplace(id, calendars.size());
+    if (inserted) {
+      calendars.service_id.push_back(id);
+      calendars.weekdays.push_back(0);
+      calendars.start_date.push_back(date);
+      calendars.end_date.push_back(date);
+    }
 
-    trips_[trip.getField("trip_id")] = trip;
-    routes_[std::make_pair(trip.getField("route_id"), trip.getField("direction_id"))]; // Create entry
+    calendar_dates.service.push_back(row->second);
+    calendar_dates.date.push_back(date);
+    calendar_dates.exception_type.push_back(static_cast<uint8_t>(exception_type));
+    appendExtraColumns(calendar_dates.extra, extra_columns, tokens);
   }
+
+  calendars.extra.pad(calendars.size());
 }
 
-void Parser::parseRoutes() {
-  std::ifstream file(inputDirectory + "routes.txt");
+void Parser::parseTrips() {
+  CsvReader reader(inputDirectory + "trips.txt");
+  const std::vector<std::string> &fields = reader.getHeader();
+  std::vector<std::string_view> tokens;
+
+  TripTable &trips = feed_.trips;
+  size_t id_column = requireColumn(reader, "trip_id", "trips.txt");
+  size_t route_column = requireColumn(reader, "route_id", "trips.txt");
+  size_t service_column = requireColumn(reader, "service_id", "trips.txt");
+  std::optional<size_t> direction_column = reader.findColumn("direction_id");
+  auto extra_columns = addExtraColumns(reader, {"trip_id", "route_id", "service_id", "direction_id"}, trips.extra);
+
+  while (reader.readRow(tokens)) {
+    if (tokens.size() != fields.size())
+      throw std::runtime_error("Mismatched number of tokens and fields");
+
+    StringId id = feed_.strings->intern(tokens[id_column]);
+    if (!trip_rows_.try_emplace(id, trips.size()).second) continue;
 
-  if (!file.is_open())
-    throw std::runtime_error("Could not open routes.txt");
+    std::optional<uint32_t> route = findRow(route_rows_, tokens[route_column]);
+    if (!route.has_value())
+      throw std::runtime_error("Trip " + std::string(tokens[id_column]) + " references unknown route "
+                               + std::string(tokens[route_column]));
 
-  std::string line;
-  std::getline(file, line);
-  Utils::clean(line);
-  std::vector<std::string> fields = Utils::split(line, ',');
+    std::optional<uint32_t> service = findRow(service_rows_, tokens[service_column]);
+    if (!service.has_value())
+      throw std::runtime_error("Trip " + std::string(tokens[id_column]) + " references unknown service "
+                               + std::string(tokens[service_column]));
 
-  while (std::getline(file, line)) {
-    Utils::clean(line);
+    std::string_view direction = optionalField(tokens, direction_column);
 
-    if (line.empty()) continue;
+    trips.trip_id.push_back(id);
+    trips.route.push_back(route.value());
+    trips.service.push_back(service.value());
+    trips.direction_id.push_back(direction.empty() ? 0 : Utils::parseInt(direction));
+    appendExtraColumns(trips.extra, extra_columns, tokens);
+  }
+}
 
-    std::vector<std::string> tokens = Utils::split(line, ',');
+void Parser::parseRoutes() {
+  CsvReader reader(inputDirectory + "routes.txt");
+  const std::vector<std::string> &fields = reader.getHeader();
+  std::vector<std::string_view> tokens;
 
+  RouteTable &routes = feed_.routes;
+  size_t id_column = requireColumn(reader, "route_id", "routes.txt");
+  std::optional<size_t> agency_column = reader.findColumn("agency_id");
+  auto extra_columns = addExtraColumns(reader, {"route_id", "agency_id"}, routes.extra);
+
+  while (reader.readRow(tokens)) {
     if (tokens.size() != fields.size())
       throw std::runtime_error("Mismatched number of tokens and fields");
 
-    Route route;
-    for (size_t i = 0; i < fields.size(); ++i)
-      route.setField(fields[i], tokens[i]);
+    StringId id = feed_.strings->intern(tokens[id_column]);
+    if (!route_rows_.try_emplace(id, routes.size()).second) continue;
 
     // If there is only one agency, agency_id field is optional
-    if (!route.hasField("agency_id"))
-      route.setField("agency_id", agencies_.begin()->second.getField("agency_id"));
-
-    // Iterate through all existing (route_id, direction_id) pairs in routes_
-    for (auto &[key, r]: routes_) {
-      // if key.route_id == route.route_id
-      auto [route_id, direction_id] = key;
-      if (route_id == route.getField("route_id")) {
-        route.setField("direction_id", direction_id);
-        routes_[key] = route;
-      }
+    uint32_t agency = 0;
+    std::string_view agency_id = optionalField(tokens, agency_column);
+    if (!agency_id.empty()) {
+      std::optional<uint32_t> agency_row = findRow(agency_rows_, agency_id);
+      if (!agency_row.has_value())
+        throw std::runtime_error("Route " + std::string(tokens[id_column]) + " references unknown agency "
+                                 + std::string(agency_id));
+      agency = agency_row.value();
+    } else if (feed_.agencies.size() == 0) {
+      throw std::runtime_error("Route " + std::string(tokens[id_column]) + " has no agency");
     }
 
+    routes.route_id.push_back(id);
+    routes.agency.push_back(agency);
+    appendExtraColumns(routes.extra, extra_columns, tokens);
   }
 }
 
 void Parser::parseStops() {
-  std::ifstream file(inputDirectory + "stops.txt");
-
-  if (!file.is_open())
-    throw std::runtime_error("Could not open stops.txt");
-
-  std::string line;
-  std::getline(file, line);
-  Utils::clean(line);
-  std::vector<std::string> fields = Utils::split(line, ',');
-
-  while (std::getline(file, line)) {
-    Utils::clean(line);
-
-    if (line.empty()) continue;
-
-    std::vector<std::string> tokens = Utils::split(line, ',');
-
+  CsvReader reader(inputDirectory + "stops.txt");
+  const std::vector<std::string> &fields = reader.getHeader();
+  std::vector<std::string_view> tokens;
+
+  StopTable &stops = feed_.stops;
+  size_t id_column = requireColumn(reader, "stop_id", "stops.txt");
+  std::optional<size_t> name_column = reader.findColumn("stop_name");
+  size_t lat_column = requireColumn(reader, "stop_lat", "stops.txt");
+  size_t lon_column = requireColumn(reader, "stop_lon", "stops.txt");
+  auto extra_columns = addExtraColumns(reader, {"stop_id", "stop_name", "stop_lat", "stop_lon"}, stops.extra);
+
+  while (reader.readRow(tokens)) {
     if (tokens.size() != fields.size())
       throw std::runtime_error("Mismatched number of tokens and fields");
 
-    Stop stop;
-    for (size_t i = 0; i < fields.size(); ++i)
-      stop.setField(fields[i], tokens[i]);
+    std::string_view id = tokens[id_column];
+    StringId stop_id = feed_.strings->intern(id);
+    if (!stop_rows_.try_emplace(stop_id, stops.size()).second) continue;
 
-    stops_[stop.getField("stop_id")] = stop;
+    double lat, lon;
+    try {
+      lat = Utils::parseDouble(tokens[lat_column]);
+      lon = Utils::parseDouble(tokens[lon_column]);
+    } catch (const std::runtime_error &e) {
+      throw std::runtime_error("Invalid latitude or longitude format for stop " + std::string(id) + ".");
+    }
+
+    stops.stop_id.push_back(stop_id);
+    stops.stop_name.emplace_back(optionalField(tokens, name_column));
+    stops.stop_lat.push_back(lat);
+    stops.stop_lon.push_back(lon);
+    appendExtraColumns(stops.extra, extra_columns, tokens);
   }
 }
 
-void Parser::parseStopTimes() {
-  std::ifstream file(inputDirectory + "stop_times.txt");
-  if (!file.is_open())
-    throw std::runtime_error("Could not open stop_times.txt");
-
-  std::string line;
-  std::getline(file, line);
-  Utils::clean(line);
-  std::vector<std::string> fields = Utils::split(line, ',');
+void Parser::parseTransfers() {
+  std::string path = inputDirectory + "/transfers.txt";
+  if (!std::filesystem::exists(path)) return; // Optional, footpaths are generated between nearby stops anyway
 
-  while (std::getline(file, line)) {
-    Utils::clean(line);
+  CsvReader reader(path);
+  const std::vector<std::string> &fields = reader.getHeader();
+  std::vector<std::string_view> tokens;
 
-    if (line.empty()) continue;
-
-    std::vector<std::string> tokens = Utils::split(line, ',');
+  TransferTable &transfers = feed_.transfers;
+  size_t from_column = requireColumn(reader, "from_stop_id", "transfers.txt");
+  size_t to_column = requireColumn(reader, "to_stop_id", "transfers.txt");
+  size_t type_column = requireColumn(reader, "transfer_type", "transfers.txt");
+  std::optional<size_t> time_column = reader.findColumn("min_transfer_time");
+  auto extra_columns = addExtraColumns(reader, {"from_stop_id", "to_stop_id", "transfer_type", "min_transfer_time"},
+                                       transfers.extra);
 
+  while (reader.readRow(tokens)) {
     if (tokens.size() != fields.size())
       throw std::runtime_error("Mismatched number of tokens and fields");
 
-    StopTime stop_time;
-
-    for (size_t i = 0; i < fields.size(); ++i)
-      stop_time.setField(fields[i], tokens[i]);
-
-    stop_time.setArrivalSeconds(Utils::timeToSeconds(stop_time.getField("arrival_time")));
-    stop_time.setDepartureSeconds(Utils::timeToSeconds(stop_time.getField("departure_time")));
-
-    stop_times_[{stop_time.getField("trip_id"), stop_time.getField("stop_id")}] = stop_time;
+    std::optional<uint32_t> from = findRow(stop_rows_, tokens[from_column]);
+    std::optional<uint32_t> to = findRow(stop_rows_, tokens[to_column]);
+    if (!from.has_value() || !to.has_value())
+      throw std::runtime_error("Transfer from " + std::string(tokens[from_column]) + " to "
+                               + std::string(tokens[to_column]) + " references an unknown stop");
+
+    // An empty transfer type is a recommended transfer
+    std::string_view type = tokens[type_column];
+    int transfer_type = type.empty() ? 0 : Utils::parseInt(type);
+    if (transfer_type < 0 || transfer_type > 3)
+      throw std::runtime_error("Invalid transfer_type " + std::string(type) + " in transfers.txt");
+
+    std::string_view time = optionalField(tokens, time_column);
+
+    transfers.from_stop.push_back(from.value());
+    transfers.to_stop.push_back(to.value());
+    transfers.transfer_type.push_back(static_cast<uint8_t>(transfer_type));
+    transfers.min_transfer_time.push_back(time.empty() ? -1 : Utils::parseInt(time));
+    appendExtraColumns(transfers.extra, extra_columns, tokens);
   }
 }
 
-void Parser::associateData() {
-  // Associate stop_times to trips
-  for (const auto &[key, stop_time]: stop_times_) {
-    const auto &[trip_id, stop_id] = key;
-    trips_[trip_id].addStopTimeKey(key);
-  }
-
-  // Sort each trip's stop_times
-  for (auto &[id, trip]: trips_)
-    trip.sortStopTimes([&](const std::pair<std::string, std::string> &a, const std::pair<std::string, std::string> &b) {
-      const StopTime &stopTimeA = stop_times_.at(a);
-      const StopTime &stopTimeB = stop_times_.at(b);
-
-      int seqA = std::stoi(stopTimeA.getField("stop_sequence"));
-      int seqB = std::stoi(stopTimeB.getField("stop_sequence"));
+void Parser::parseStopTimes(ThreadPool &pool) {
+  CsvReader reader(inputDirectory + "stop_times.txt");
+  std::string_view data = reader.getRemaining();
 
-      return seqA < seqB;
-    });
+  // Split the rows into byte ranges, each starting at the beginning of a line
+  // Quoted fields may contain line breaks, so a file with quotes is parsed as a single range
+  size_t num_chunks = reader.hasQuotes() ? 1 : pool.size() * 4;
+  std::vector<size_t> boundaries = {0};
+  for (size_t chunk = 1; chunk < num_chunks; ++chunk) {
+    size_t offset = std::max(data.size() * chunk / num_chunks, boundaries.back());
 
-  // Associate trips to routes
-  for (auto &[id, trip]: trips_) {
-    auto route_key = std::make_pair(trip.getField("route_id"), trip.getField("direction_id"));
-    routes_[route_key].addTripId(id);
+    size_t line_end = data.find('\n', offset == 0 ? 0 : offset - 1);
+    boundaries.push_back(line_end == std::string_view::npos ? data.size() : line_end + 1);
   }
-
-  // Sort each route's trip by earliest to latest arrival time
-  for (auto &[id, route]: routes_)
-    route.sortTrips([&](const std::string &a, const std::string &b) {
-      const Trip &tripA = trips_.at(a);
-      const Trip &tripB = trips_.at(b);
-
-      const StopTime &stopTimeA = stop_times_.at(tripA.getStopTimesKeys().front());
-      const StopTime &stopTimeB = stop_times_.at(tripB.getStopTimesKeys().front());
-
-      int timeA = Utils::timeToSeconds(stopTimeA.getField("arrival_time"));
-      int timeB = Utils::timeToSeconds(stopTimeB.getField("arrival_time"));
-
-      return timeA < timeB;
-    });
-
-  // Associate stops to routes
-  for (auto &[key, route]: routes_) {
-    // If there is no trip associated to this route, skip the route
-    if (route.getTripsIds().empty()) continue;
-
-    // Find the route's trip that has the most stops
-    Trip &largest_trip = trips_[route.getTripsIds()[0]];
-    for (size_t i = 1; i < route.getTripsIds().size(); i++) {
-      Trip &trip = trips_[route.getTripsIds()[i]];
-      if (trip.getStopTimesKeys().size() > largest_trip.getStopTimesKeys().size()) {
-        largest_trip = trip;
-      }
-    }
-
-    // A route stops' order will be the same as the routes' largest_trip stops' order, because it has the most stops
-    for (const auto &[trip_id, stop_id]: largest_trip.getStopTimesKeys()) {
-      route.addStopId(stop_id);
-    }
-  }
-
-  for (auto &[key, stop_time]: stop_times_) {
-    auto &[trip_id, stop_id] = key;
-    // Associate stop_times to stops
-    stops_[stop_id].addStopTimeKey(key);
-
-    // Associate routes to stops
-    stops_[stop_id].addRouteKey(
-            std::make_pair(trips_[trip_id].getField("route_id"), trips_[trip_id].getField("direction_id")));
+  boundaries.push_back(data.size());
+
+  // Rows by ID, resolved once so that the workers look each field up with a single hash and no lock
+  std::vector<std::string_view> strings = feed_.strings->view();
+  std::unordered_map<std::string_view, uint32_t> trip_rows, stop_rows;
+  trip_rows.reserve(trip_rows_.size());
+  stop_rows.reserve(stop_rows_.size());
+  for (const auto &[id, row]: trip_rows_)
+    trip_rows.emplace(strings[id], row);
+  for (const auto &[id, row]: stop_rows_)
+    stop_rows.emplace(strings[id], row);
+
+  std::vector<StopTimeTable> chunks(num_chunks);
+  pool.parallelFor(num_chunks, [&](size_t chunk) {
+    CsvReader chunk_reader(data.substr(boundaries[chunk], boundaries[chunk + 1] - boundaries[chunk]),
+                           reader.getHeader());
+    chunks[chunk] = parseStopTimesChunk(chunk_reader, trip_rows, stop_rows);
+  });
+
+  // Concatenate in file order
+  StopTimeTable &stop_times = feed_.stop_times;
+  size_t num_stop_times = 0;
+  for (const auto &chunk: chunks)
+    num_stop_times += chunk.size();
+
+  stop_times.trip.reserve(num_stop_times);
+  stop_times.stop.reserve(num_stop_times);
+  stop_times.stop_sequence.reserve(num_stop_times);
+  stop_times.arrival_seconds.reserve(num_stop_times);
+  stop_times.departure_seconds.reserve(num_stop_times);
+
+  std::vector<uint32_t> rows;
+  for (const auto &chunk: chunks) {
+    rows.resize(chunk.size());
+    std::iota(rows.begin(), rows.end(), 0);
+    stop_times.extra.appendRows(chunk.extra, rows, stop_times.size());
+
+    stop_times.trip.insert(stop_times.trip.end(), chunk.trip.begin(), chunk.trip.end());
+    stop_times.stop.insert(stop_times.stop.end(), chunk.stop.begin(), chunk.stop.end());
+    stop_times.stop_sequence.insert(stop_times.stop_sequence.end(), chunk.stop_sequence.begin(), chunk.stop_sequence.end());
+    stop_times.arrival_seconds.insert(stop_times.arrival_seconds.end(), chunk.arrival_seconds.begin(), chunk.arrival_seconds.end());
+    stop_times.departure_seconds.insert(stop_times.departure_seconds.end(), chunk.departure_seconds.begin(), chunk.departure_seconds.end());
   }
-
-  // Sort each stop's stop_times by earliest to latest departure time
-  for (auto &[id, stop]: stops_)
-    stop.sortStopTimes([&](const std::pair<std::string, std::string> &a, const std::pair<std::string, std::string> &b) {
-      const StopTime &stopTimeA = stop_times_.at(a);
-      const StopTime &stopTimeB = stop_times_.at(b);
-
-      int timeA = Utils::timeToSeconds(stopTimeA.getField("departure_time"));
-      int timeB = Utils::timeToSeconds(stopTimeB.getField("departure_time"));
-
-      return timeA < timeB;
-    });
-
-
 }
 
-std::unordered_map<std::string, Agency> Parser::getAgencies() {
-  return agencies_;
-}
+StopTimeTable Parser::parseStopTimesChunk(CsvReader &reader,
+                                          const std::unordered_map<std::string_view, uint32_t> &trip_rows,
+                                          const std::unordered_map<std::string_view, uint32_t> &stop_rows) const {
+  const std::vector<std::string> &fields = reader.getHeader();
+  std::vector<std::string_view> tokens;
+  StopTimeTable stop_times;
+
+  size_t trip_column = requireColumn(reader, "trip_id", "stop_times.txt");
+  size_t stop_column = requireColumn(reader, "stop_id", "stop_times.txt");
+  size_t sequence_column = requireColumn(reader, "stop_sequence", "stop_times.txt");
+  size_t arrival_column = requireColumn(reader, "arrival_time", "stop_times.txt");
+  size_t departure_column = requireColumn(reader, "departure_time", "stop_times.txt");
+  auto extra_columns = addExtraColumns(reader, {"trip_id", "stop_id", "stop_sequence", "arrival_time", "departure_time"},
+                                       stop_times.extra);
+
+  while (reader.readRow(tokens)) {
+    if (tokens.size() != fields.size())
+      throw std::runtime_error("Mismatched number of tokens and fields");
 
-std::unordered_map<std::string, Calendar> Parser::getCalendars() {
-  return calendars_;
-}
+    auto trip = trip_rows.find(tokens[trip_column]);
+    if (trip == trip_rows.end())
+      throw std::runtime_error("Stop time references unknown trip " + std::string(tokens[trip_column]));
+
+    auto stop = stop_rows.find(tokens[stop_column]);
+    if (stop == stop_rows.end())
+      throw std::runtime_error("Trip " + std::string(tokens[trip_column]) + " references unknown stop "
+                               + std::string(tokens[stop_column]));
+
+    // Times are only required at timepoints, so a missing time takes the other one
+    std::string_view arrival_time = tokens[arrival_column];
+    std::string_view departure_time = tokens[departure_column];
+    if (arrival_time.empty()) arrival_time = departure_time;
+    if (departure_time.empty()) departure_time = arrival_time;
+
+    stop_times.trip.push_back(trip->second);
+    stop_times.stop.push_back(stop->second);
+    stop_times.stop_sequence.push_back(Utils::parseInt(tokens[sequence_column]));
+    stop_times.arrival_seconds.push_back(Utils::parseTime(arrival_time));
+    stop_times.departure_seconds.push_back(Utils::parseTime(departure_time));
+    appendExtraColumns(stop_times.extra, extra_columns, tokens);
+  }
 
-std::unordered_map<std::string, Stop> Parser::getStops() {
-  return stops_;
+  return stop_times;
 }
 
-std::unordered_map<std::pair<std::string, std::string>, Route, pair_hash> Parser::getRoutes() {
-  return routes_;
-}
+std::optional<uint32_t> Parser::findRow(const std::unordered_map<StringId, uint32_t> &rows, std::string_view id) const {
+  std::optional<StringId> handle = feed_.strings->find(id);
+  if (!handle.has_value()) return std::nullopt;
 
-std::unordered_map<std::string, Trip> Parser::getTrips() {
-  return trips_;
+  auto it = rows.find(handle.value());
+  if (it == rows.end()) return std::nullopt;
+  return it->second;
 }
 
-std::unordered_map<std::pair<std::string, std::string>, StopTime, pair_hash> Parser::getStopTimes() {
-  return stop_times_;
+const GTFSFeed &Parser::getFeed() const {
+  return feed_;
 }
-
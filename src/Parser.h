@@ -12,17 +12,14 @@
 #include <sstream> // for string stream
 #include <iostream> // for input and output
 #include <chrono> // for timing
+#include <limits> // for numeric_limits
 
 #include "Utils.h" // for hash functions
+#include "ThreadPool.h" // for parallel parsing
+#include "CsvReader.h" // for tokenizing files
 
-#include "NetworkObjects/GTFSObjects/GTFSObject.h" // for GTFSObject
 #include "NetworkObjects/DataStructures.h" // for DataStructures
-#include "NetworkObjects/GTFSObjects/Agency.h" // for Agency
-#include "NetworkObjects/GTFSObjects/Calendar.h" // for Calendar
-#include "NetworkObjects/GTFSObjects/Route.h" // for Route
-#include "NetworkObjects/GTFSObjects/Stop.h" // for Stop
-#include "NetworkObjects/GTFSObjects/Trip.h" // for Trip
-#include "NetworkObjects/GTFSObjects/StopTime.h" // for StopTime
+#include "NetworkObjects/GTFSFeed.h" // for GTFSFeed
 
 /**
  * @class Parser
@@ -37,106 +34,113 @@ private:
 
   std::string inputDirectory; /**< Directory where the input files are located. */
 
-  /**
-   * Maps to store parsed data.
-   */
-  std::unordered_map<std::string, Agency> agencies_; ///< A map from agency IDs to Agency objects.
-  std::unordered_map<std::string, Calendar> calendars_; ///< A map from calendar IDs to Calendar objects.
-  std::unordered_map<std::string, Stop> stops_; ///< A map from stop IDs to Stop objects.
-  std::unordered_map<std::pair<std::string, std::string>, Route, pair_hash> routes_; ///< A map from (route_id, direction_id) to Route objects.
-  std::unordered_map<std::string, Trip> trips_; ///< A map from trip IDs to Trip objects.
-  std::unordered_map<std::pair<std::string, std::string>, StopTime, pair_hash> stop_times_; ///< A map from (trip_id, stop_id) to StopTime objects.
-
-  /**
-   * @brief Parses the agencies file and stores the results in the agencies_ map.
-   */
-  void parseAgencies();
+  GTFSFeed feed_; ///< The parsed tables.
 
   /**
-   * @brief Parses the calendars file and stores the results in the calendars_ map.
+   * Maps from the interned IDs of each file to their rows, used to resolve references between files.
    */
-  void parseCalendars();
+  std::unordered_map<StringId, uint32_t> agency_rows_; ///< A map from agency IDs to agency rows.
+  std::unordered_map<StringId, uint32_t> service_rows_; ///< A map from service IDs to calendar rows.
+  std::unordered_map<StringId, uint32_t> route_rows_; ///< A map from route IDs to route rows.
+  std::unordered_map<StringId, uint32_t> stop_rows_; ///< A map from stop IDs to stop rows.
+  std::unordered_map<StringId, uint32_t> trip_rows_; ///< A map from trip IDs to trip rows.
 
   /**
-   * @brief Parses the routes file and stores the results in the routes_ map.
+   * @brief Looks up the row of an ID.
+   *
+   * @param[in] rows The map from interned IDs to rows of the referenced file.
+   * @param[in] id The ID.
+   * @return The row, or `std::nullopt` if the ID is unknown.
    */
-  void parseRoutes();
+  std::optional<uint32_t> findRow(const std::unordered_map<StringId, uint32_t> &rows, std::string_view id) const;
 
   /**
-   * @brief Parses the stops file and stores the results in the stops_ map.
+   * @brief Parses the agencies file and stores the results in the agencies table.
    */
-  void parseStops();
+  void parseAgencies();
 
   /**
-   * @brief Parses the trips file and stores the results in the trips_ map.
+   * @brief Parses the calendars file and stores the results in the calendars table.
    */
-  void parseTrips();
+  void parseCalendars();
 
   /**
-   * @brief Parses the stop times file and stores the results in the stop_times_ map.
+   * @brief Parses the calendar dates file, if any, and stores the results in the calendar dates table.
+   *
+   * Must run after parseCalendars(). Services that calendar.txt does not define are added to the calendars table.
    */
-  void parseStopTimes();
+  void parseCalendarDates();
 
   /**
-   * @brief Associates data across various GTFS components (routes, trips, stops, etc.).
+   * @brief Parses the routes file and stores the results in the routes table.
    *
-   * This method processes the data from different GTFS files and associates the relevant information
-   * such as matching trips with corresponding stops and stop times.
+   * Must run after parseAgencies(). If a route has no agency_id, it is operated by the first agency.
    */
-  void associateData();
-
-public:
+  void parseRoutes();
 
   /**
-   * @brief Constructor for the Parser class.
-   *
-   * Initializes the parser with the specified directory containing the GTFS data files.
-   *
-   * @param[in] directory Path to the directory containing the GTFS files.
+   * @brief Parses the stops file and stores the results in the stops table.
    */
-  explicit Parser(std::string directory);
+  void parseStops();
 
   /**
-   * @brief Gets the parsed agencies data.
+   * @brief Parses the transfers file, if any, and stores the results in the transfers table.
    *
-   * @return A map of agency IDs to Agency objects.
+   * Must run after parseStops().
    */
-  [[nodiscard]] std::unordered_map<std::string, Agency> getAgencies();
+  void parseTransfers();
 
   /**
-   * @brief Gets the parsed calendars data.
+   * @brief Parses the trips file and stores the results in the trips table.
    *
-   * @return A map of calendar IDs to Calendar objects.
+   * Must run after parseRoutes() and parseCalendarDates().
    */
-  [[nodiscard]] std::unordered_map<std::string, Calendar> getCalendars();
+  void parseTrips();
 
   /**
-   * @brief Gets the parsed stops data.
+   * @brief Parses the stop times file and stores the results in the stop times table.
    *
-   * @return A map of stop IDs to Stop objects.
+   * Must run after parseTrips() and parseStops().
+   * The file is memory-mapped and split into byte ranges, aligned to line boundaries,
+   * which are parsed in parallel and concatenated in file order.
+   *
+   * @param[in] pool The thread pool on which the chunks are parsed.
    */
-  [[nodiscard]] std::unordered_map<std::string, Stop> getStops();
+  void parseStopTimes(ThreadPool &pool);
 
   /**
-   * @brief Gets the parsed routes data.
+   * @brief Parses the stop times of a chunk of the stop times file.
    *
-   * @return A map of (route_id, direction_id) pairs to Route objects.
+   * @param[in,out] reader The reader over the chunk.
+   * @param[in] trip_rows The row of each trip, by ID.
+   * @param[in] stop_rows The row of each stop, by ID.
+   * @return The parsed stop times, in file order.
    */
-  [[nodiscard]] std::unordered_map<std::pair<std::string, std::string>, Route, pair_hash> getRoutes();
+  StopTimeTable parseStopTimesChunk(CsvReader &reader, const std::unordered_map<std::string_view, uint32_t> &trip_rows,
+                                    const std::unordered_map<std::string_view, uint32_t> &stop_rows) const;
+
+public:
 
   /**
-   * @brief Gets the parsed trips data.
+   * @brief Constructor for the Parser class.
    *
-   * @return A map of trip IDs to Trip objects.
+   * Initializes the parser with the specified directory containing the GTFS data files.
+   * Independent files are parsed concurrently.
+   *
+   * @param[in] directory Path to the directory containing the GTFS files.
+   * @param[in] pool The thread pool to parse on, or `nullptr` to create one for this parser.
+   * @param[in] strings The interner for the IDs, shared by the parsers of feeds that will be merged,
+   *            or `nullptr` to create one for this parser.
    */
-  [[nodiscard]] std::unordered_map<std::string, Trip> getTrips();
+  explicit Parser(std::string directory, ThreadPool *pool = nullptr,
+                  std::shared_ptr<StringInterner> strings = nullptr);
 
   /**
-   * @brief Gets the parsed stop times data.
+   * @brief Gets the parsed data.
    *
-   * @return A map of (trip_id, stop_id) pairs to StopTime objects.
+   * @return A constant reference to the tables of the feed, with stop times grouped by trip.
    */
-  [[nodiscard]] std::unordered_map<std::pair<std::string, std::string>, StopTime, pair_hash> getStopTimes();
+  [[nodiscard]] const GTFSFeed &getFeed() const;
 };
 
 #endif //PARSE_H
@@ -0,0 +1,54 @@
+/**
+ * @file QueryContext.h
+ * @brief Defines the QueryContext struct, the scratch state of a RAPTOR query.
+ *
+ * This header file declares the QueryContext struct, which holds everything a query writes
+ * while it runs, so that the Timetable stays immutable and can be shared between threads.
+ */
+
+#ifndef RAPTOR_QUERYCONTEXT_H
+#define RAPTOR_QUERYCONTEXT_H
+
+#include <vector>
+#include <optional>
+#include <array>
+
+#include "NetworkObjects/DataStructures.h"
+#include "RoundLabels.h"
+#include "LabelBags.h"
+#include "BitSet.h"
+
+/**
+ * @struct ServiceDay
+ * @brief A day on which a query may take the trips whose service runs.
+ */
+struct ServiceDay {
+  int day; ///< Day relative to the query date, negative for trips of previous days still running.
+  uint32_t period_day; ///< Day in the timetable's service period, as returned by Timetable::findServiceDay().
+};
+
+/**
+ * @struct QueryContext
+ * @brief Labels, marked stops and service days of one query, single or multi-criteria.
+ *
+ * A context may be reused by consecutive queries, but must not be used by two queries at once.
+ * Each thread answering queries holds its own.
+ */
+struct QueryContext {
+  Query query; ///< The query being answered.
+  StopId source{}; ///< Index of the query's source stop.
+  std::optional<StopId> target; ///< Index of the query's target stop, or `std::nullopt` for one-to-all queries.
+  RoundLabels arrivals; ///< StopInfo of each stop (by index) for each k, kept allocated across queries.
+  BitSet prev_marked_stops; ///< Set of previously marked stops.
+  BitSet marked_stops; ///< Set of currently marked stops.
+  std::vector<RouteId> queued_routes; ///< Routes to traverse in the current round.
+  std::vector<uint32_t> queued_positions; ///< Earliest marked position of each queued route, NO_POSITION otherwise.
+  std::vector<ServiceDay> service_days; ///< Days whose trips may be taken, in increasing order.
+  LabelBags bags; ///< Labels of multi-criteria queries, and the bag of each stop, kept allocated across queries.
+  std::vector<Label> route_bag; ///< Labels riding the trips of the route being scanned by a multi-criteria query.
+  std::array<bool, NUM_CRITERIA> criteria{}; ///< Whether each Criterion is optimised by the multi-criteria query.
+  int k{}; ///< The current round of the algorithm.
+  bool verbose = true; ///< Whether the rounds and journeys found are written to std::cout.
+};
+
+#endif //RAPTOR_QUERYCONTEXT_H
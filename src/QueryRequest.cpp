@@ -0,0 +1,354 @@
+/**
+ * @file QueryRequest.cpp
+ * @brief QueryRequest struct implementation
+ *
+ * This file contains the implementation of the QueryRequest struct, which reads
+ * requests from JSON objects and writes the journeys or arrivals answering them as JSON.
+ */
+
+#include "QueryRequest.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <sstream>
+#include <unordered_map>
+
+/**
+ * @struct JsonValue
+ * @brief A scalar value of a JSON object.
+ */
+struct JsonValue {
+  std::string text; ///< The decoded string, or the literal of any other value.
+  bool string;      ///< True if the value is a string.
+};
+
+/**
+ * @brief Checks if a value is a JSON literal other than a string.
+ * @param[in] literal The value.
+ * @return True if the value is a number, `true`, `false` or `null`.
+ */
+static bool isLiteral(std::string_view literal) {
+  if (literal == "true" || literal == "false" || literal == "null") return true;
+
+  size_t i = 0;
+  auto digits = [&]() {
+    size_t start = i;
+    while (i < literal.size() && std::isdigit(static_cast<unsigned char>(literal[i]))) ++i;
+    return i - start;
+  };
+
+  // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+  if (i < literal.size() && literal[i] == '-') ++i;
+  if (i < literal.size() && literal[i] == '0') {
+    ++i;
+  } else if (digits() == 0) {
+    return false;
+  }
+
+  if (i < literal.size() && literal[i] == '.') {
+    ++i;
+    if (digits() == 0) return false;
+  }
+
+  if (i < literal.size() && (literal[i] == 'e' || literal[i] == 'E')) {
+    ++i;
+    if (i < literal.size() && (literal[i] == '+' || literal[i] == '-')) ++i;
+    if (digits() == 0) return false;
+  }
+
+  return i == literal.size();
+}
+
+/**
+ * @brief Parses a JSON object whose values are scalars.
+ * @param[in] json The object.
+ * @return The value of each key.
+ * @throws std::runtime_error If the object is malformed, or a value is an array, an object or not valid JSON.
+ */
+static std::unordered_map<std::string, JsonValue> parseObject(std::string_view json) {
+  size_t i = 0;
+
+  auto skipSpaces = [&]() {
+    while (i < json.size() && std::isspace(static_cast<unsigned char>(json[i]))) ++i;
+  };
+
+  auto expect = [&](char c) {
+    skipSpaces();
+    if (i >= json.size() || json[i] != c) throw std::runtime_error(std::string("Expected '") + c + "' in request.");
+    ++i;
+  };
+
+  auto parseString = [&]() {
+    expect('"');
+
+    std::string value;
+    while (true) {
+      if (i >= json.size()) throw std::runtime_error("Unterminated string in request.");
+
+      char c = json[i++];
+      if (c == '"') break;
+      if (c != '\\') {
+        value += c;
+        continue;
+      }
+
+      if (i >= json.size()) throw std::runtime_error("Unterminated string in request.");
+      switch (char escaped = json[i++]) {
+        case 'b': value += '\b'; break;
+        case 'f': value += '\f'; break;
+        case 'n': value += '\n'; break;
+        case 'r': value += '\r'; break;
+        case 't': value += '\t'; break;
+        case 'u': {
+          if (i + 4 > json.size()
+              || !std::all_of(json.begin() + i, json.begin() + i + 4,
+                              [](char h) { return std::isxdigit(static_cast<unsigned char>(h)); }))
+            throw std::runtime_error("Invalid escape in request.");
+          unsigned code = std::stoul(std::string(json.substr(i, 4)), nullptr, 16);
+          i += 4;
+
+          // Encode the code point as UTF-8
+          if (code < 0x80) {
+            value += static_cast<char>(code);
+          } else if (code < 0x800) {
+            value += static_cast<char>(0xC0 | (code >> 6));
+            value += static_cast<char>(0x80 | (code & 0x3F));
+          } else {
+            value += static_cast<char>(0xE0 | (code >> 12));
+            value += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            value += static_cast<char>(0x80 | (code & 0x3F));
+          }
+          break;
+        }
+        default: value += escaped;
+      }
+    }
+
+    return value;
+  };
+
+  std::unordered_map<std::string, JsonValue> object;
+
+  expect('{');
+  skipSpaces();
+  if (i < json.size() && json[i] == '}') {
+    ++i;
+  } else {
+    while (true) {
+      std::string key = parseString();
+      expect(':');
+      skipSpaces();
+
+      if (i < json.size() && json[i] == '"') {
+        object[key] = {parseString(), true};
+      } else {
+        size_t start = i;
+        while (i < json.size() && json[i] != ',' && json[i] != '}'
+               && !std::isspace(static_cast<unsigned char>(json[i])))
+          ++i;
+
+        std::string literal(json.substr(start, i - start));
+        if (!isLiteral(literal)) throw std::runtime_error("Invalid value of " + key + " in request.");
+        object[key] = {literal, false};
+      }
+
+      skipSpaces();
+      if (i < json.size() && json[i] == ',') {
+        ++i;
+        continue;
+      }
+      expect('}');
+      break;
+    }
+  }
+
+  skipSpaces();
+  if (i != json.size()) throw std::runtime_error("Unexpected characters after request.");
+
+  return object;
+}
+
+/**
+ * @brief Parses a time of a request.
+ * @param[in] str The time, as HH:MM:SS.
+ * @return The time.
+ * @throws std::runtime_error If the time is malformed or not within a day.
+ */
+static Time parseRequestTime(const std::string &str) {
+  int seconds = Utils::parseTime(str);
+  if (seconds >= MIDNIGHT) throw std::runtime_error("Invalid time: " + str);
+  return {seconds / 3600, seconds / 60 % 60, seconds % 60};
+}
+
+/**
+ * @brief Writes a journey as JSON.
+ * @param[in,out] out The stream to write to.
+ * @param[in] journey The journey.
+ * @param[in] timetable The timetable the journey was found on.
+ */
+static void writeJourney(std::ostream &out, const Journey &journey, const Timetable &timetable) {
+  out << "{\"departure\":" << QueryRequest::quote(Utils::secondsToTime(journey.departure_secs))
+      << ",\"arrival\":" << QueryRequest::quote(Utils::secondsToTime(journey.arrival_secs))
+      << ",\"duration\":" << journey.duration << ",\"steps\":[";
+
+  for (size_t i = 0; i < journey.steps.size(); ++i) {
+    const JourneyStep &step = journey.steps[i];
+
+    out << (i > 0 ? "," : "")
+        << "{\"trip\":"
+        << (step.trip_id != NO_TRIP ? QueryRequest::quote(timetable.getTripId(step.trip_id)) : "null")
+        << ",\"agency\":"
+        << (step.agency_id != NO_AGENCY ? QueryRequest::quote(timetable.getAgencyName(step.agency_id)) : "null")
+        << ",\"from\":" << QueryRequest::quote(timetable.getStopId(step.src_stop))
+        << ",\"to\":" << QueryRequest::quote(timetable.getStopId(step.dest_stop))
+        << ",\"day\":" << QueryRequest::quote(Utils::dayToString(step.day))
+        << ",\"departure\":" << QueryRequest::quote(Utils::secondsToTime(step.departure_secs))
+        << ",\"arrival\":" << QueryRequest::quote(Utils::secondsToTime(step.arrival_secs)) << "}";
+  }
+
+  out << "]}";
+}
+
+/**
+ * @brief Gets a string field of a request.
+ * @param[in] object The request.
+ * @param[in] name The name of the field.
+ * @return The value of the field, or `std::nullopt` if the request does not have it or it is null.
+ * @throws std::runtime_error If the field is not a string.
+ */
+static std::optional<std::string> stringField(const std::unordered_map<std::string, JsonValue> &object,
+                                              const std::string &name) {
+  auto it = object.find(name);
+  if (it == object.end() || (!it->second.string && it->second.text == "null")) return std::nullopt;
+  if (!it->second.string) throw std::runtime_error("Field " + name + " must be a string.");
+  return it->second.text;
+}
+
+QueryRequest QueryRequest::fromJson(std::string_view json) {
+  QueryRequest request;
+
+  try {
+    std::unordered_map<std::string, JsonValue> object = parseObject(json);
+
+    auto id = object.find("id");
+    if (id != object.end()) request.id = id->second.string ? quote(id->second.text) : id->second.text;
+
+    request.source = stringField(object, "source").value_or("");
+    request.target = stringField(object, "target").value_or("");
+    request.date = stringField(object, "date").value_or("");
+    request.time = stringField(object, "time").value_or("");
+    request.latest_time = stringField(object, "latest_time");
+    request.criteria = stringField(object, "criteria");
+
+  } catch (const std::exception &e) {
+    request.error = e.what();
+  }
+
+  return request;
+}
+
+std::string QueryRequest::answer(const Raptor &raptor, QueryContext &context) const {
+  try {
+    if (!error.empty()) throw std::runtime_error(error);
+    if (source.empty()) throw std::runtime_error("Missing field source.");
+    if (date.empty()) throw std::runtime_error("Missing field date.");
+    if (time.empty()) throw std::runtime_error("Missing field time.");
+
+    const Timetable &timetable = raptor.getTimetable();
+
+    if (!timetable.findStop(source).has_value()) throw std::runtime_error("Unknown source stop " + source + ".");
+    if (!target.empty() && !timetable.findStop(target).has_value())
+      throw std::runtime_error("Unknown target stop " + target + ".");
+
+    int yyyymmdd = Utils::parseDate(date);
+    int year = yyyymmdd / 10000, month = yyyymmdd / 100 % 100, day = yyyymmdd % 100;
+    if (month < 1 || month > 12 || day < 1 || day > Utils::daysInMonth(year, month))
+      throw std::runtime_error("Invalid date: " + date);
+
+    context.query = {source, target, {year, month, day, Utils::getWeekday(year, month, day)}, parseRequestTime(time)};
+
+    if (latest_time.has_value()) {
+      context.query.latest_departure_time = parseRequestTime(latest_time.value());
+      if (Utils::timeToSeconds(context.query.latest_departure_time.value())
+          < Utils::timeToSeconds(context.query.departure_time))
+        throw std::runtime_error("Latest departure time is before the departure time.");
+    }
+
+    if (criteria.has_value()) {
+      if (target.empty()) throw std::runtime_error("Multi-criteria queries need a target stop.");
+      if (latest_time.has_value()) throw std::runtime_error("Multi-criteria queries have no departure window.");
+      context.query.criteria = Utils::parseCriteria(criteria.value());
+    }
+
+    std::ostringstream out;
+    out << "{\"id\":" << id;
+
+    if (target.empty()) {
+      // Earliest arrival at every reachable stop
+      RoundArrivals arrivals = raptor.findAllArrivals(context);
+
+      out << ",\"arrivals\":{";
+      bool first = true;
+      for (StopId stop_id = 0; stop_id < timetable.numStops(); ++stop_id) {
+        if (!arrivals.back()[stop_id].has_value()) continue;
+
+        out << (first ? "" : ",") << quote(timetable.getStopId(stop_id)) << ":"
+            << quote(Utils::secondsToTime(arrivals.back()[stop_id]));
+        first = false;
+      }
+      out << "}";
+
+    } else {
+      std::vector<Journey> journeys = criteria.has_value() ? raptor.findMultiCriteriaJourneys(context)
+                                      : latest_time.has_value() ? raptor.findProfileJourneys(context)
+                                      : raptor.findJourneys(context);
+
+      out << ",\"journeys\":[";
+      for (size_t i = 0; i < journeys.size(); ++i) {
+        if (i > 0) out << ",";
+        writeJourney(out, journeys[i], timetable);
+      }
+      out << "]";
+    }
+
+    out << "}";
+    return out.str();
+
+  } catch (const std::exception &e) {
+    return "{\"id\":" + id + ",\"error\":" + quote(e.what()) + "}";
+  }
+}
+
+std::string QueryRequest::answer(const Raptor &raptor) const {
+  thread_local QueryContext context;
+  context.verbose = false;
+
+  return answer(raptor, context);
+}
+
+void QueryRequest::addField(std::string &response, std::string_view name, std::string_view value) {
+  response.pop_back(); // Closing brace
+  response += ",";
+  response += quote(name);
+  response += ":";
+  response += value;
+  response += "}";
+}
+
+std::string QueryRequest::quote(std::string_view str) {
+  std::string quoted = "\"";
+  for (char c: str) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[7];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      quoted += escaped;
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + '"';
+}
@@ -0,0 +1,82 @@
+/**
+ * @file QueryRequest.h
+ * @brief Defines the QueryRequest struct, a query received as text and answered as JSON.
+ *
+ * This header file declares the QueryRequest struct, shared by the query server, which receives
+ * requests as JSON objects, and the batch runner, which reads them from CSV rows.
+ */
+
+#ifndef RAPTOR_QUERYREQUEST_H
+#define RAPTOR_QUERYREQUEST_H
+
+#include <string>
+#include <string_view>
+#include <optional>
+
+#include "Raptor.h"
+
+/**
+ * @struct QueryRequest
+ * @brief The fields of a query, as received.
+ *
+ * Without a target, the earliest arrival at every reachable stop is answered instead of journeys,
+ * with a latest time, the journeys of a profile query over the departure window, and with criteria,
+ * the journeys of a multi-criteria query.
+ */
+struct QueryRequest {
+  std::string id = "null";                ///< ID echoed in the response, as JSON.
+  std::string source;                     ///< ID of the source stop.
+  std::string target;                     ///< ID of the target stop, empty for one-to-all queries.
+  std::string date;                       ///< Date of the journey, as YYYYMMDD.
+  std::string time;                       ///< Departure time, as HH:MM:SS.
+  std::optional<std::string> latest_time; ///< End of the departure window, as HH:MM:SS, for profile queries.
+  std::optional<std::string> criteria;    ///< Criteria, as read by Utils::parseCriteria(), for multi-criteria queries.
+  std::string error;                      ///< Why the request could not be read, empty if it could.
+
+  /**
+   * @brief Reads a request from a JSON object.
+   *
+   * @param[in] json The object, with the string fields `source`, `target`, `date`, `time`, `latest_time`
+   *            and `criteria`, and any scalar `id`.
+   * @return The request. Malformed objects and fields that are not strings are reported in its error.
+   */
+  static QueryRequest fromJson(std::string_view json);
+
+  /**
+   * @brief Answers the request.
+   *
+   * @param[in] raptor The router answering the query.
+   * @param[in,out] context The scratch state of the query.
+   * @return The JSON response, without trailing newline. Invalid requests get an `error` field.
+   */
+  std::string answer(const Raptor &raptor, QueryContext &context) const;
+
+  /**
+   * @brief Answers the request with the context of the calling thread.
+   *
+   * Each worker of a pool reuses its own context, and its labels, across the requests it answers.
+   *
+   * @param[in] raptor The router answering the query.
+   * @return The JSON response, without trailing newline. Invalid requests get an `error` field.
+   */
+  std::string answer(const Raptor &raptor) const;
+
+  /**
+   * @brief Adds a field to a JSON response.
+   *
+   * @param[in,out] response The response.
+   * @param[in] name The name of the field.
+   * @param[in] value The value of the field, as JSON.
+   */
+  static void addField(std::string &response, std::string_view name, std::string_view value);
+
+  /**
+   * @brief Quotes a string as a JSON string.
+   *
+   * @param[in] str The string.
+   * @return The string, escaped and quoted.
+   */
+  static std::string quote(std::string_view str);
+};
+
+#endif //RAPTOR_QUERYREQUEST_H
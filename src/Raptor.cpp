@@ -10,518 +10,922 @@
  */
 #include "Raptor.h"
 
-Raptor::Raptor(const std::unordered_map<std::string, Agency> &agencies,
-               const std::unordered_map<std::string, Calendar> &calendars,
-               const std::unordered_map<std::string, Stop> &stops,
-               const std::unordered_map<std::pair<std::string, std::string>, Route, pair_hash> &routes,
-               const std::unordered_map<std::string, Trip> &trips,
-               const std::unordered_map<std::pair<std::string, std::string>, StopTime, pair_hash> &stop_times)
-        : agencies_(agencies), calendars_(calendars), stops_(stops), routes_(routes), trips_(trips),
-          stop_times_(stop_times) {
-  k = 1;
+#include <limits>
+#include <queue>
 
+#include "ParetoSet.h"
+
+/**
+ * @struct JourneyTraits
+ * @brief Journeys compared by duration and number of steps, sorted by number of steps.
+ */
+struct JourneyTraits {
+  /**
+   * @brief Gets the criterion journeys are sorted by.
+   * @param[in] journey The journey.
+   * @return The number of steps of the journey.
+   */
+  static size_t key(const Journey &journey) { return journey.steps.size(); }
+
+  /**
+   * @brief Compares two journeys to check if one dominates the other.
+   *
+   * Of two journeys with the same number of steps, the quicker one dominates, and a journey with more steps
+   * is dominated unless it is quicker. Journeys equal in both criteria do not dominate each other.
+   *
+   * @param[in] journey1 The first journey.
+   * @param[in] journey2 The second journey.
+   * @return True if the first journey dominates the second, false otherwise.
+   */
+  static bool dominates(const Journey &journey1, const Journey &journey2) {
+    return (journey1.duration < journey2.duration && journey1.steps.size() <= journey2.steps.size())
+           || (journey1.steps.size() < journey2.steps.size() && journey1.duration <= journey2.duration);
+  }
+
+  static constexpr bool SKYLINE = true; ///< Only the duration is compared besides the number of steps.
+};
+
+/**
+ * @struct ProfileJourneyTraits
+ * @brief Journeys of a profile compared by departure, arrival and number of steps, sorted by latest departure.
+ */
+struct ProfileJourneyTraits {
+  /**
+   * @brief Gets the criterion journeys are sorted by.
+   * @param[in] journey The journey.
+   * @return The departure of the journey, negated so that later departures come first.
+   */
+  static int key(const Journey &journey) { return -journey.departure_secs; }
+
+  /**
+   * @brief Compares two journeys of a profile.
+   * @param[in] journey1 The first journey.
+   * @param[in] journey2 The second journey.
+   * @return True if the first journey leaves no earlier, arrives no later and has no more steps.
+   */
+  static bool dominates(const Journey &journey1, const Journey &journey2) {
+    return journey1.departure_secs >= journey2.departure_secs
+           && journey1.arrival_secs <= journey2.arrival_secs
+           && journey1.steps.size() <= journey2.steps.size();
+  }
+
+  static constexpr bool SKYLINE = false; ///< Arrival and number of steps are both compared besides departure.
+};
+
+Raptor::Raptor(const GTFSFeed &feed, std::optional<int> max_walking_duration) {
   std::cout << "Raptor initialized with "
-            << agencies_.size() << " agencies, "
-            << calendars_.size() << " calendars, "
-            << stops.size() << " stops, "
-            << routes.size() << " routes, "
-            << trips.size() << " trips and "
-            << stop_times.size() << " stop times." << std::endl;
+            << feed.agencies.size() << " agencies, "
+            << feed.calendars.size() << " calendars, "
+            << feed.stops.size() << " stops, "
+            << feed.routes.size() << " routes, "
+            << feed.trips.size() << " trips and "
+            << feed.stop_times.size() << " stop times." << std::endl;
+
+  timetable_ = Timetable(feed, initializeFootpaths(feed, max_walking_duration));
+
+  std::cout << "Timetable compiled with " << timetable_.numRoutes() << " routes and "
+            << timetable_.numStopEvents() << " stop events." << std::endl;
+}
 
-  initializeFootpaths();
+Raptor::Raptor(Timetable timetable) : timetable_(std::move(timetable)) {
+  std::cout << "Raptor initialized with " << timetable_.numStops() << " stops, "
+            << timetable_.numRoutes() << " routes, "
+            << timetable_.numTrips() << " trips and "
+            << timetable_.numStopEvents() << " stop events." << std::endl;
 }
 
 void Raptor::setQuery(const Query &query) {
-  query_ = query;
+  context_.query = query;
+}
+
+/**
+ * @brief Applies the transfers of a feed between different stops to footpaths.
+ *
+ * A timed transfer takes no time, one with a minimum time takes that time, or the walk without one,
+ * and one that is not possible removes the footpath.
+ *
+ * @param[in] feed The feed.
+ * @param[in,out] footpaths The footpaths from each stop row, to other stop rows.
+ */
+static void applyTransfers(const GTFSFeed &feed, std::vector<std::vector<Footpath>> &footpaths) {
+  const StopTable &stops = feed.stops;
+
+  for (uint32_t row = 0; row < feed.transfers.size(); ++row) {
+    uint32_t from_row = feed.transfers.from_stop[row], to_row = feed.transfers.to_stop[row];
+    if (from_row == to_row) continue; // A change time, set by the timetable
+
+    std::vector<Footpath> &from_footpaths = footpaths[from_row];
+    auto footpath = std::find_if(from_footpaths.begin(), from_footpaths.end(),
+                                 [&](const Footpath &f) { return f.to == to_row; });
+
+    uint8_t type = feed.transfers.transfer_type[row];
+    if (type == 3) {
+      if (footpath != from_footpaths.end()) from_footpaths.erase(footpath);
+      continue;
+    }
+
+    // Timed transfers wait for the passengers, other transfers take their minimum time or the walk
+    int duration = type == 1 ? 0 : feed.transfers.min_transfer_time[row];
+    if (duration < 0)
+      duration = Utils::getDuration(stops.stop_lat[from_row], stops.stop_lon[from_row],
+                                    stops.stop_lat[to_row], stops.stop_lon[to_row]);
+
+    if (footpath != from_footpaths.end()) footpath->duration = duration;
+    else from_footpaths.push_back({to_row, duration});
+  }
 }
 
-void Raptor::initializeFootpaths() {
+std::vector<std::vector<Footpath>> Raptor::initializeFootpaths(const GTFSFeed &feed,
+                                                               std::optional<int> max_walking_duration) {
+  const StopTable &stops = feed.stops;
+
   // Initialize footpaths
   std::cout << "Initializing footpaths..." << std::endl;
   auto start_time = std::chrono::high_resolution_clock::now();
 
-  // Avoid duplicating calculations for both sides
-  for (auto it1 = stops_.begin(); it1 != stops_.end(); ++it1) {
-    const std::string &id1 = it1->first;  // Get stop_id
-    Stop &stop1 = it1->second;  // Get stop itself
-
-    // Start the inner loop from the next element
-    for (auto it2 = std::next(it1); it2 != stops_.end(); ++it2) {
-      const std::string &id2 = it2->first; // Get stop_id
-      Stop &stop2 = it2->second; // stop itself
-
-      // Calculate duration between the two stops
-      int duration = Utils::getDuration(
-              stop1.getField("stop_lat"), stop1.getField("stop_lon"),
-              stop2.getField("stop_lat"), stop2.getField("stop_lon"));
+  std::vector<std::vector<Footpath>> footpaths(stops.size());
+  std::vector<Coordinates> coordinates;
+  coordinates.reserve(stops.size());
+  for (size_t i = 0; i < stops.size(); ++i)
+    coordinates.push_back({stops.stop_lat[i], stops.stop_lon[i]});
+
+  auto addFootpaths = [&](uint32_t i, uint32_t j) {
+    int duration = Utils::getDuration(coordinates[i].lat, coordinates[i].lon, coordinates[j].lat, coordinates[j].lon);
+    if (max_walking_duration.has_value() && duration > max_walking_duration.value()) return;
+
+    // Add footpaths in both directions
+    footpaths[i].push_back({j, duration});
+    footpaths[j].push_back({i, duration});
+  };
+
+  if (!max_walking_duration.has_value()) {
+    // Connect every pair of stops, avoiding duplicating calculations for both sides
+    for (uint32_t i = 0; i < stops.size(); ++i)
+      for (uint32_t j = i + 1; j < stops.size(); ++j)
+        addFootpaths(i, j);
+
+  } else if (max_walking_duration.value() > 0) {
+    // Slightly widen the radius, since durations are rounded to the second
+    double radius = Utils::getWalkingRadius(max_walking_duration.value() + 1);
+    SpatialGrid grid(coordinates, radius);
+
+    for (uint32_t i = 0; i < stops.size(); ++i)
+      for (uint32_t j: grid.findWithin(coordinates[i], radius))
+        if (j > i) addFootpaths(i, j); // Avoid duplicating calculations for both sides
+
+    // Transfers shorter than the walk, or between distant stops, can be followed by a walk
+    applyTransfers(feed, footpaths);
+
+    // Close the walking graph with a Dijkstra bounded by the longest walk from every stop,
+    // so that a footpath never needs to follow another
+    std::vector<std::vector<Footpath>> closed(stops.size());
+    std::vector<int> durations(stops.size(), UNREACHED);
+    std::vector<uint32_t> reached;
+    std::priority_queue<std::pair<int, uint32_t>, std::vector<std::pair<int, uint32_t>>, std::greater<>> queue;
+
+    for (uint32_t source = 0; source < stops.size(); ++source) {
+      durations[source] = 0;
+      reached.push_back(source);
+      queue.emplace(0, source);
+
+      while (!queue.empty()) {
+        auto [duration, stop] = queue.top();
+        queue.pop();
+        if (duration > durations[stop]) continue; // Already settled with a shorter walk
+
+        if (stop != source) closed[source].push_back({stop, duration});
+
+        for (const auto &[next, walk]: footpaths[stop]) {
+          int next_duration = duration + walk;
+          if (next_duration > max_walking_duration.value() || next_duration >= durations[next]) continue;
+
+          if (durations[next] == UNREACHED) reached.push_back(next);
+          durations[next] = next_duration;
+          queue.emplace(next_duration, next);
+        }
+      }
 
-      // Add footpaths in both directions
-      stop1.addFootpath(id2, duration);
-      stop2.addFootpath(id1, duration);
+      for (uint32_t stop: reached) durations[stop] = UNREACHED;
+      reached.clear();
     }
+
+    footpaths = std::move(closed);
   }
 
+  // The stops of a transfer keep its own duration, or stay apart, whatever the chains between them
+  applyTransfers(feed, footpaths);
+
+  size_t num_footpaths = 0;
+  for (const std::vector<Footpath> &stop_footpaths: footpaths) num_footpaths += stop_footpaths.size();
+
   auto end_time = std::chrono::high_resolution_clock::now();
 
   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
 
-  std::cout << "Footpaths initialized in " << duration << " ms ("
+  std::cout << num_footpaths << " footpaths initialized in " << duration << " ms ("
             << duration / 1000 << " seconds)." << std::endl;
+
+  return footpaths;
 }
 
-void Raptor::initializeAlgorithm() {
+void Raptor::initializeAlgorithm(QueryContext &context, bool ignore_target) const {
   // Format departure time to HH:MM:00
   std::ostringstream time_oss;
-  time_oss << std::setw(2) << std::setfill('0') << query_.departure_time.hours << ":"
-           << std::setw(2) << std::setfill('0') << query_.departure_time.minutes << ":00";
+  time_oss << std::setw(2) << std::setfill('0') << context.query.departure_time.hours << ":"
+           << std::setw(2) << std::setfill('0') << context.query.departure_time.minutes << ":00";
+
+  std::optional<StopId> source = timetable_.findStop(context.query.source_id);
+  if (!source.has_value()) throw std::runtime_error("Unknown source stop " + context.query.source_id + ".");
+  context.source = source.value();
+
+  context.target = std::nullopt;
+  if (!ignore_target && !context.query.target_id.empty()) {
+    context.target = timetable_.findStop(context.query.target_id);
+    if (!context.target.has_value()) throw std::runtime_error("Unknown target stop " + context.query.target_id + ".");
+  }
 
   // Print query details
-  std::cout << "Query from " << stops_[query_.source_id].getField("stop_name")
-            << " to " << stops_[query_.target_id].getField("stop_name")
-            << " departing " << query_.date.day << "/" << query_.date.month << "/" << query_.date.year
-            << " (" << weekdays_names[query_.date.weekday]
-            << ") at " << time_oss.str() << std::endl << std::endl;
+  log(context) << "Query from " << timetable_.getStopName(context.source)
+               << " to " << (context.target.has_value() ? timetable_.getStopName(context.target.value()) : "all stops")
+               << " departing " << context.query.date.day << "/" << context.query.date.month
+               << "/" << context.query.date.year
+               << " (" << weekdays_names[context.query.date.weekday]
+               << ") at " << time_oss.str() << std::endl << std::endl;
 
   // Initialize data structures
-  arrivals_.clear();
-  prev_marked_stops.clear();
-  marked_stops.clear();
-
-  // Initialize arrival times for all stops
-  for (const auto &[id, stop]: stops_)
-    arrivals_[id] = std::vector<StopInfo>(1, {std::nullopt, std::nullopt, std::nullopt, std::nullopt});
+  // Labels of the previous query are not cleared, but left behind by a new epoch
+  context.arrivals.reset(timetable_.numStops());
+  context.prev_marked_stops.resize(timetable_.numStops());
+  context.marked_stops.resize(timetable_.numStops());
+
+  // Queued positions are reset as routes are traversed, so only routes left queued need to be
+  if (context.queued_positions.size() != timetable_.numRoutes())
+    context.queued_positions.assign(timetable_.numRoutes(), NO_POSITION);
+  for (RouteId route_id: context.queued_routes) context.queued_positions[route_id] = NO_POSITION;
+  context.queued_routes.clear();
+
+  // Trips of previous days whose times go past 24:00:00 may still run, up to the end of the horizon
+  // Trips are active on a day if their service's bit for the day is set, so only the days are looked up
+  context.service_days.clear();
+  int query_day = Utils::daysSinceEpoch(context.query.date.year, context.query.date.month, context.query.date.day);
+  for (int day = -static_cast<int>(timetable_.numOvernightDays()); day < context.query.horizon_days; ++day) {
+    std::optional<uint32_t> period_day = timetable_.findServiceDay(Utils::dateFromDays(query_day + day));
+    if (period_day.has_value()) context.service_days.push_back({day, period_day.value()});
+  }
+}
 
-  // Initialize the round 0
-  k = 0;
-  markStop(query_.source_id, Utils::timeToSeconds(query_.departure_time), std::nullopt, std::nullopt);
+void Raptor::setMinArrivalTime(QueryContext &context, StopId stop_id, const StopInfo &stop_info) const {
+  context.arrivals.set(context.k, stop_id, stop_info);
+}
 
-  k++; // k=1
 
-  // Fill active trips for current and next day
-  fillActiveTrips(Day::CurrentDay);
-  fillActiveTrips(Day::NextDay);
+std::vector<Journey> Raptor::findJourneys() {
+  return findJourneys(context_);
 }
 
-void Raptor::setMinArrivalTime(const std::string &stop_id, StopInfo stop_info) {
+std::vector<Journey> Raptor::findJourneys(QueryContext &context) const {
+  initializeAlgorithm(context);
 
-  if (arrivals_[stop_id].size() <= k)
-    arrivals_[stop_id].resize(k + 1);
+  std::vector<Journey> journeys = runRounds(context, Utils::timeToSeconds(context.query.departure_time));
 
-  arrivals_[stop_id][k] = std::move(stop_info);
+  size_t before_filtering = journeys.size();
 
-}
+  // Keep only pareto-optimal journeys
+  keepParetoOptimal(journeys);
 
-void Raptor::fillActiveTrips(Day day) {
-  Date target_date = (day == Day::CurrentDay) ? query_.date : Utils::addOneDay(query_.date);
+  size_t after_filtering = journeys.size();
 
-  // Iterates over all trips
-  for (auto &[trip_id, trip]: trips_) {
-    // Get service calendar for the trip
-    const Calendar &calendar = calendars_.at(trip.getField("service_id"));
+  if (before_filtering > after_filtering)
+    log(context) << "Discarded " << before_filtering - after_filtering << " journeys." << std::endl;
+  return journeys;
+}
 
-    // Check if the service is active for the target date
-    // Only active services are considered
-    if (isServiceActive(calendar, target_date))
-      trip.setActive(day, true);
-    else
-      trip.setActive(day, false);
-  }
+std::vector<Journey> Raptor::findProfileJourneys() {
+  return findProfileJourneys(context_);
 }
 
+std::vector<Journey> Raptor::findProfileJourneys(QueryContext &context) const {
+  initializeAlgorithm(context);
+
+  int earliest = Utils::timeToSeconds(context.query.departure_time);
+  int latest = Utils::timeToSeconds(context.query.latest_departure_time.value_or(context.query.departure_time));
+  if (latest < earliest) throw std::runtime_error("Latest departure time is before the departure time.");
+
+  std::vector<int> departures = collectDepartures(context, earliest, latest);
+  log(context) << "Profile over " << departures.size() << " departure(s)." << std::endl;
 
-std::vector<Journey> Raptor::findJourneys() {
   std::vector<Journey> journeys;
 
-  initializeAlgorithm();
+  // Latest departure first, so that the labels of each run bound the runs of earlier departures
+  for (int departure: departures) {
+    log(context) << std::endl << "Departure at " << Utils::secondsToTime(departure) << std::endl;
 
-  while (true) {
+    // Journeys boarding after the window are still needed as bounds, but are not part of the profile
+    for (Journey &journey: runRounds(context, departure))
+      if (journey.departure_secs <= latest) journeys.push_back(std::move(journey));
+  }
 
-    // Print round number
-    std::cout << std::endl << "Round " << k << std::endl << std::endl;
+  size_t before_filtering = journeys.size();
 
-    // Set upper bound for arrival times
-    // Use the minimum arrival time from the previous round as the base for the current round
-    setUpperBound();
+  // Keep only pareto-optimal journeys
+  keepProfileParetoOptimal(journeys);
 
-    // Update previous marked stops and clear current marked stops
-    // Only focus on active stops from the previous round
-    prev_marked_stops = marked_stops;
-    marked_stops.clear();
+  size_t after_filtering = journeys.size();
 
-    // Accumulate routes serving marked stops from previous round
-    // ((route_id, direction_id), stop_id)
-    // routes_stops_set:
-    // {
-    //   {(route_id, direction_id), stop_id},
-    //   {(route_id, direction_id), stop_id},
-    //   ...
-    // }
-    std::unordered_set<std::pair<std::pair<std::string, std::string>, std::string>, nested_pair_hash> routes_stops_set = accumulateRoutesServingStops();
-    std::cout << "Accumulated " << routes_stops_set.size() << " routes serving stops." << std::endl;
+  if (before_filtering > after_filtering)
+    log(context) << "Discarded " << before_filtering - after_filtering << " journeys." << std::endl;
+  return journeys;
+}
 
-    // 2nd: Traverse each route
-    traverseRoutes(routes_stops_set);
-    std::cout << "Traversed routes. " << marked_stops.size() << " stop(s) improved." << std::endl;
+std::vector<Journey> Raptor::findMultiCriteriaJourneys() {
+  return findMultiCriteriaJourneys(context_);
+}
 
-    // Look for footpaths
-    handleFootpaths();
-    std::cout << "Handled footpaths. " << marked_stops.size() << " stop(s) improved." << std::endl;
+std::vector<Journey> Raptor::findMultiCriteriaJourneys(QueryContext &context) const {
+  initializeAlgorithm(context);
+  if (!context.target.has_value()) throw std::runtime_error("Multi-criteria queries need a target stop.");
 
-    // Stopping criterion: if no stops are marked, then stop
-    if (marked_stops.empty()) break;
+  context.criteria.fill(false);
+  for (Criterion criterion: context.query.criteria) context.criteria[static_cast<size_t>(criterion)] = true;
 
-    if (marked_stops.find(query_.target_id) != marked_stops.end()) {
-      std::cout << "Target improved! Reconstructing journey..." << std::endl;
+  // Labels of the previous query are dropped, and only the bags it wrote are cleared
+  context.bags.reset(timetable_.numStops());
+  context.prev_marked_stops.clear();
+  context.marked_stops.clear();
 
-      Journey journey = reconstructJourney();
+  // Round 0: the source, and the stops within walking distance of it
+  context.k = 0;
+  Label source;
+  source.arrival_seconds = Utils::timeToSeconds(context.query.departure_time);
+  source.stop_id = context.source;
+  insertLabel(context, source);
+  handleFootpathBags(context);
 
-      if (isValidJourney(journey)) {
-        journeys.push_back(journey);
+  while (true) {
+    context.k++;
 
-        std::cout << "Found journey with " << journey.steps.size() << " step(s)." << std::endl;
-        Raptor::showJourney(journey);
-      }
+    log(context) << std::endl << "Round " << context.k << std::endl << std::endl;
+
+    std::swap(context.prev_marked_stops, context.marked_stops);
+    context.marked_stops.clear();
+
+    accumulateRoutesServingStops(context);
+    log(context) << "Accumulated " << context.queued_routes.size() << " routes serving stops." << std::endl;
+
+    for (RouteId route_id: context.queued_routes) {
+      uint32_t start = context.queued_positions[route_id];
+      context.queued_positions[route_id] = NO_POSITION;
+      scanRouteBags(context, route_id, start);
     }
+    context.queued_routes.clear();
+    log(context) << "Traversed routes. " << context.marked_stops.count() << " bag(s) improved." << std::endl;
 
-    k++;
-  }
+    handleFootpathBags(context);
+    log(context) << "Handled footpaths. " << context.marked_stops.count() << " bag(s) improved." << std::endl;
 
-  size_t before_filtering = journeys.size();
+    // Stopping criterion: if no bag improved, no label can be extended
+    if (context.marked_stops.empty()) break;
+  }
 
-  // Keep only pareto-optimal journeys
-  keepParetoOptimal(journeys);
+  // The bag of the target holds the Pareto-optimal journeys, by arrival time
+  std::vector<Journey> journeys;
+  for (const BagLabel &bag_label: context.bags.getBag(context.target.value())) {
+    Journey journey = reconstructJourney(context.bags, bag_label.index);
+    if (!isValidJourney(journey, context)) continue;
 
-  size_t after_filtering = journeys.size();
+    log(context) << std::endl << "Found journey with " << journey.steps.size() << " step(s)." << std::endl;
+    if (context.verbose) showJourney(journey);
+    journeys.push_back(std::move(journey));
+  }
 
-  if (before_filtering > after_filtering)
-    std::cout << "Discarded " << before_filtering - after_filtering << " journeys." << std::endl;
   return journeys;
 }
 
-void Raptor::setUpperBound() {
-  // Use the minimum arrival time from the previous round as the base for the current round
-  for (const auto &[stop_id, stop]: stops_)
-    setMinArrivalTime(stop_id, arrivals_[stop_id][k - 1]);
+RoundArrivals Raptor::findAllArrivals() {
+  return findAllArrivals(context_);
 }
 
-// Define the type of routes_stops_set
-std::unordered_set<std::pair<std::pair<std::string, std::string>, std::string>, nested_pair_hash>
-Raptor::accumulateRoutesServingStops() {
-  std::unordered_set<std::pair<std::pair<std::string, std::string>, std::string>, nested_pair_hash> routes_stops_set;
+RoundArrivals Raptor::findAllArrivals(QueryContext &context) const {
+  // Without a target, nothing is pruned and every stop keeps its labels
+  initializeAlgorithm(context, true);
 
-  // For each previously marked stop p
-  for (const auto &marked_stop_id: prev_marked_stops) {
+  runRounds(context, Utils::timeToSeconds(context.query.departure_time));
 
-    if (marked_stop_id == query_.target_id) continue; // No need to accumulate routes serving the target stop
+  // The last round improved no stop, so its labels equal the previous round's
+  RoundArrivals arrivals(context.k, std::vector<std::optional<int>>(timetable_.numStops()));
+  for (int round = 0; round < context.k; ++round)
+    for (StopId stop_id = 0; stop_id < timetable_.numStops(); ++stop_id)
+      if (int arrival = context.arrivals.getArrival(round, stop_id); arrival != UNREACHED)
+        arrivals[round][stop_id] = arrival;
 
-    // For each route r serving p
-    // Route key: (route_id, direction_id)
-    for (const auto &route_key: stops_[marked_stop_id].getRouteKeys()) {
-
-      // Initialize a flag to check if the route already has a point in the list
-      // Make sure that max. one stop is added per route
-      bool already_has_point = false;
-      // Iterate over all stops in the route
-      for (std::string stop_id: routes_[route_key].getStopsIds()) {
-
-        // Check if a point p' is already in the list
-        // If not, existing_entry is routes_stops_set.end()
-        auto existing_entry = routes_stops_set.find({route_key, stop_id});
-        // For route r, if a point p' is already in the list, then we need to check if marked_p comes before p'
-        // Only the first stop of a route is added to the list
-        if (existing_entry != routes_stops_set.end()) {
-          // Avoid adding the same stop twice
-          already_has_point = true;
-
-          // Find the position of marked_p in the route
-          auto it_marked = std::find_if(routes_[route_key].getStopsIds().begin(),
-                                        routes_[route_key].getStopsIds().end(),
-                                        [&](const std::string &s_id) { return s_id == marked_stop_id; });
-          // Find the position of p' in the route
-          auto it_stop = std::find_if(routes_[route_key].getStopsIds().begin(), routes_[route_key].getStopsIds().end(),
-                                      [&](const std::string &s_id) { return s_id == stop_id; });
-
-          if (it_marked < it_stop) { // if marked_p comes before p'
-            routes_stops_set.erase(existing_entry);
-            routes_stops_set.insert({route_key, marked_stop_id});
-          } // else (if marked_p does not come before p'), we do not add it to the set and leave the p' entry
-        }
-      }
+  return arrivals;
+}
 
-      // If the route does not have a point in the list, then add the stop
-      if (!already_has_point)
-        routes_stops_set.insert({route_key, marked_stop_id});
-      // TODO: avoid accumulating routes that do not have any active trip
-    }
+std::vector<std::vector<std::optional<int>>> Raptor::findArrivalMatrix(const std::vector<std::string> &source_ids,
+                                                                       const std::vector<std::string> &target_ids,
+                                                                       const Date &date, const Time &departure_time) {
+  return findArrivalMatrix(source_ids, target_ids, date, departure_time, context_);
+}
+
+std::vector<std::vector<std::optional<int>>> Raptor::findArrivalMatrix(const std::vector<std::string> &source_ids,
+                                                                       const std::vector<std::string> &target_ids,
+                                                                       const Date &date, const Time &departure_time,
+                                                                       QueryContext &context) const {
+  std::vector<StopId> targets;
+  targets.reserve(target_ids.size());
+  for (const std::string &target_id: target_ids) {
+    std::optional<StopId> target = timetable_.findStop(target_id);
+    if (!target.has_value()) throw std::runtime_error("Unknown target stop " + target_id + ".");
+    targets.push_back(target.value());
+  }
+
+  std::vector<std::vector<std::optional<int>>> matrix;
+  matrix.reserve(source_ids.size());
+
+  // One query per source reaches every target at once
+  for (const std::string &source_id: source_ids) {
+    if (!timetable_.findStop(source_id).has_value()) throw std::runtime_error("Unknown source stop " + source_id + ".");
+
+    context.query = {source_id, "", date, departure_time};
+    RoundArrivals arrivals = findAllArrivals(context);
+
+    std::vector<std::optional<int>> &row = matrix.emplace_back();
+    row.reserve(targets.size());
+    for (StopId target: targets)
+      row.push_back(arrivals.back()[target]);
   }
 
-  // Return the set of routes serving stops
-  return routes_stops_set;
+  return matrix;
 }
 
-void Raptor::traverseRoutes(
-        std::unordered_set<std::pair<std::pair<std::string, std::string>, std::string>, nested_pair_hash> routes_stops_set) {
-  
-  // Iterate over all routes in the set
-  auto route_stop = routes_stops_set.begin();
-  while (route_stop != routes_stops_set.end()) {
-    // Get the route key and the stop id
-    const auto &[route_key, p_stop_id] = *route_stop;
-    // Get the route
-    const Route &route = routes_[route_key];
-    // Find the position of the stop in the route
-    auto stop_it = std::find_if(route.getStopsIds().begin(), route.getStopsIds().end(),
-                                [&](const std::string &s_id) {
-                                  return s_id == p_stop_id;
-                                });
+std::vector<int> Raptor::collectDepartures(const QueryContext &context, int earliest, int latest) const {
+  // The end of the window itself, for journeys that start by walking as late as possible
+  std::vector<int> departures = {latest};
+
+  // Departures within the window from a stop, of the trips of every service day, shifted by the walk to reach it
+  auto addDepartures = [&](StopId stop_id, int walk) {
+    // A route visiting the stop more than once is listed once per visit
+    for (const auto &[route_id, position]: timetable_.getStopRoutes(stop_id)) {
+      const RouteInfo &route = timetable_.getRoute(route_id);
+      if (position + 1 == route.num_stops) continue; // No trip departs from the last stop
+
+      std::span<const int> route_departures = timetable_.getDepartures(route_id, position);
+      for (const auto &[day, period_day]: context.service_days) {
+        int shift = day * MIDNIGHT - walk;
+
+        // Departures are sorted, so only those within the window are visited
+        auto first = std::lower_bound(route_departures.begin(), route_departures.end(), earliest - shift);
+        for (auto it = first; it != route_departures.end() && *it + shift <= latest; ++it) {
+          auto trip_id = static_cast<TripId>(route.first_trip + (it - route_departures.begin()));
+          if (timetable_.isTripActive(trip_id, period_day)) departures.push_back(*it + shift);
+        }
+      }
+    }
+  };
 
-    // For each stop pi on this route, try to find the earliest trip (et) that can be taken
-    // Iterate over all stops in the route after the stop p
-    for (auto it = stop_it; it != route.getStopsIds().end(); ++it) {
-      // Get the stop id
-      std::string pi_stop_id = *it;
+  addDepartures(context.source, 0);
+  for (const auto &[stop_id, duration]: timetable_.getFootpaths(context.source))
+    addDepartures(stop_id, duration);
 
-      // Get the arrival time of the stop in the previous round k-1
-      std::optional<int> stop_prev_arrival = arrivals_[pi_stop_id][k - 1].arrival_seconds; // TODO: really k-1?
+  std::sort(departures.begin(), departures.end(), std::greater<>());
+  departures.erase(std::unique(departures.begin(), departures.end()), departures.end());
 
-      // If stop is not reachable in the previous round k-1, no trip can be caught
-      if (!stop_prev_arrival.has_value()) continue;
+  return departures;
+}
 
-      // Find the earliest trip in route r that can be caught at stop pi in round k
-      auto et = findEarliestTrip(pi_stop_id, route_key);
+std::vector<Journey> Raptor::runRounds(QueryContext &context, int departure) const {
+  // Rounds in which the target improved, whose journeys are reconstructed once the rounds are over
+  std::vector<int> target_rounds;
 
-      // If a valid trip was found, traverse the trip
-      if (et.has_value()) {
-        std::string et_id = et.value().first;
-        Day et_day = et.value().second;
-        traverseTrip(et_id, et_day, pi_stop_id);
-      } else continue; // No valid trip found for this stop
+  context.prev_marked_stops.clear();
+  context.marked_stops.clear();
 
-    } // end each stop pi on route
+  // Initialize the round 0
+  context.k = 0;
+  markStop(context, context.source, {departure});
 
-    route_stop = routes_stops_set.erase(route_stop);
-  } // end each route
+  context.k++; // k=1
 
-}
+  while (true) {
 
-std::optional<std::pair<std::string, Day>>
-Raptor::findEarliestTrip(const std::string &pi_stop_id, const std::pair<std::string, std::string> &route_key) {
+    // Print round number
+    log(context) << std::endl << "Round " << context.k << std::endl << std::endl;
 
-  std::optional<Day> stop_day = arrivals_[pi_stop_id][k - 1].day;
-  std::optional<int> stop_prev_arrival = arrivals_[pi_stop_id][k - 1].arrival_seconds;
+    // The labels of the previous round are the upper bounds of this one: a stop not improved in this round
+    // reads its label from the previous round, and labels left by runs of later departures are only kept if earlier
 
-  // If stop is not reachable, no trip can be caught
-  if (!stop_day.has_value()) return std::nullopt;
+    // Update previous marked stops and clear current marked stops
+    // Only focus on active stops from the previous round
+    std::swap(context.prev_marked_stops, context.marked_stops);
+    context.marked_stops.clear();
 
-  // Find the earliest trip in route r that can be caught at stop pi in round k
-  for (const auto &stop_time_key: stops_[pi_stop_id].getStopTimesKeys()) {
-    const StopTime &stop_time = stop_times_.at(stop_time_key);
+    // Accumulate routes serving marked stops from previous round
+    // queued_positions: route -> position of the earliest marked stop of the route
+    accumulateRoutesServingStops(context);
+    log(context) << "Accumulated " << context.queued_routes.size() << " routes serving stops." << std::endl;
 
-    if (earlier(stop_time.getDepartureSeconds(),
-                stop_prev_arrival)) // If departure time is earlier than arrival
-      continue;
+    // 2nd: Traverse each route
+    traverseRoutes(context);
+    log(context) << "Traversed routes. " << context.marked_stops.count() << " stop(s) improved." << std::endl;
 
-    if (isValidTrip(route_key, stop_time, stop_day.value()))
-      // We can return because a stop's stop_times is ordered
-      return std::make_pair(stop_time.getField("trip_id"), stop_day.value());
-  }
+    // Look for footpaths
+    handleFootpaths(context);
+    log(context) << "Handled footpaths. " << context.marked_stops.count() << " stop(s) improved." << std::endl;
 
-  // If no trip was found for the current day, try the next day
-  for (const auto &stop_time_key: stops_[pi_stop_id].getStopTimesKeys()) {
-    const StopTime &stop_time = stop_times_.at(stop_time_key);
+    // Stopping criterion: if no stops are marked, then stop
+    if (context.marked_stops.empty()) break;
 
-    if ((stop_day.value() == Day::NextDay)
-        && earlier(stop_time.getDepartureSeconds(),
-                   stop_prev_arrival)) // If departure time is earlier than arrival
-      continue;
+    if (context.target.has_value() && context.marked_stops.contains(context.target.value())) {
+      log(context) << "Target improved!" << std::endl;
+      target_rounds.push_back(context.k);
+    }
 
-    if (isValidTrip(route_key, stop_time, Day::NextDay))
-      // We can return because a stop's stop_times is ordered
-      return std::make_pair(stop_time.getField("trip_id"), Day::NextDay);
+    context.k++;
   }
 
-  return std::nullopt;
+  // Labels of a round are never written by later rounds, so the journeys of every round can still be followed
+  std::vector<Journey> journeys;
+  for (int round: target_rounds) {
+    Journey journey = reconstructJourney(context, round);
+    if (!isValidJourney(journey, context)) continue;
+
+    log(context) << std::endl << "Found journey with " << journey.steps.size() << " step(s) in round " << round
+                 << "." << std::endl;
+    if (context.verbose) showJourney(journey);
+    journeys.push_back(std::move(journey));
+  }
+
+  return journeys;
 }
 
-bool Raptor::isValidTrip(const std::pair<std::string, std::string> &route_key,
-                         const StopTime &stop_time, const Day &day) {
+void Raptor::accumulateRoutesServingStops(QueryContext &context) const {
+  // For each previously marked stop p
+  context.prev_marked_stops.forEach([&](StopId marked_stop_id) {
 
-  const std::string &trip_id = stop_time.getField("trip_id");
-  const Trip &trip = trips_[trip_id];
+    if (marked_stop_id == context.target) return; // No need to accumulate routes serving the target stop
 
-  auto [route_id, direction_id] = route_key;
+    // For each route r serving p
+    for (const auto &[route_id, position]: timetable_.getStopRoutes(marked_stop_id)) {
 
-  // Check if the stop_time is from a trip that belongs to the route being traversed
-  if ((trip.getField("route_id") != route_id) || (trip.getField("direction_id") != direction_id))
-    return false;
+      // Make sure that max. one stop is added per route, the one that comes first
+      uint32_t &queued_position = context.queued_positions[route_id];
+      if (queued_position == NO_POSITION) context.queued_routes.push_back(route_id);
+      queued_position = std::min(queued_position, position);
+      // TODO: avoid accumulating routes that do not have any active trip
+    }
+  });
+}
 
-  int departure_secs = day == Day::CurrentDay ? stop_time.getDepartureSeconds()
-                                              : stop_time.getDepartureSeconds() + MIDNIGHT;
-  std::optional<int> stop_prev_arrival = arrivals_[stop_time.getField("stop_id")][k - 1].arrival_seconds;
-  std::optional<int> target_arrival = arrivals_[query_.target_id][k].arrival_seconds;
+void Raptor::traverseRoutes(QueryContext &context) const {
 
-  if (trip.isActive(day)
-      && !earlier(departure_secs, stop_prev_arrival) // Does not depart earlier than stop's arrival
-      && earlier(departure_secs, target_arrival)) // Departs earlier than target's arrival
-    return true;
+  // Iterate over all routes
+  for (RouteId route_id: context.queued_routes) {
+    uint32_t start = context.queued_positions[route_id];
+    context.queued_positions[route_id] = NO_POSITION;
+    scanRoute(context, route_id, start);
+  }
 
-  return false;
+  context.queued_routes.clear();
 }
 
-bool Raptor::isServiceActive(const Calendar &calendar, const Date &date) {
+void Raptor::scanRoute(QueryContext &context, RouteId route_id, uint32_t start) const {
+  std::span<const StopId> route_stops = timetable_.getRouteStops(route_id);
 
-  // Check if the date is within the calendar's start and end dates
-  if (!Utils::dateWithinRange(date, calendar.getField("start_date"), calendar.getField("end_date")))
-    return false;
+  std::optional<std::pair<TripId, int>> et; // Current trip, and its service day
+  int et_offset{}; // Seconds from the query date to the service day of the current trip
+  std::span<const StopEvent> et_stop_events; // Stop events of the current trip, by position in the route
+  StopId boarding_stop_id{}; // Stop where the current trip was boarded
+  uint32_t boarding_position{}; // Position of that stop in the route
 
-  // Check if the day of the week is active
-  return std::stoi(calendar.getField(weekdays_names[date.weekday]));
-}
+  for (uint32_t position = start; position < route_stops.size(); ++position) {
+    StopId pi_stop_id = route_stops[position];
 
-// TODO: create a struct for stop_time_key
-// TODO: use .at() instead of []
-void Raptor::traverseTrip(std::string &et_id, Day &et_day, std::string &pi_stop_id) {
-  Trip et = trips_.at(et_id);
+    // If arrival time can be improved, update Tk(pi) using et
+    if (et.has_value()) {
+      const StopEvent &stop_event = et_stop_events[position];
+      int arr_secs = stop_event.arrival_seconds + et_offset;
 
-  auto et_stop_it = std::find_if(et.getStopTimesKeys().begin(), et.getStopTimesKeys().end(),
-                                 [&](const std::pair<std::string, std::string> &st_key) {
-                                   return st_key.second == pi_stop_id;
-                                 });
+      if (improvesArrivalTime(context, arr_secs, pi_stop_id))
+        markStop(context, pi_stop_id, {arr_secs, et->first, boarding_stop_id, boarding_position, et->second});
+    }
 
-  // Traverse remaining stops on the trip to update arrival times
-  for (auto next_stop_time_key = std::next(et_stop_it);
-       next_stop_time_key != et.getStopTimesKeys().end(); ++next_stop_time_key) {
+    // If stop is not reachable in the previous round k-1, no trip can be caught
+    if (context.arrivals.getArrival(context.k - 1, pi_stop_id) == UNREACHED) continue;
+
+    // Check if an earlier trip can be caught at stop pi (because a quicker path was found in a previous round)
+    auto earlier_trip = findEarliestTrip(context, route_id, position, et);
+    if (earlier_trip.has_value()) {
+      et = earlier_trip;
+      et_offset = et->second * MIDNIGHT;
+      et_stop_events = timetable_.getTripStopEvents(et->first);
+      boarding_stop_id = pi_stop_id;
+      boarding_position = position;
+    }
+  }
+}
 
-    auto [_, next_stop_id] = *next_stop_time_key;
-    StopTime &next_stop_time = stop_times_[*next_stop_time_key];
+std::optional<std::pair<TripId, int>>
+Raptor::findEarliestTrip(const QueryContext &context, RouteId route_id, uint32_t position,
+                         const std::optional<std::pair<TripId, int>> &current_trip) const {
+  const RouteInfo &route = timetable_.getRoute(route_id);
+  StopId pi_stop_id = timetable_.getRouteStops(route_id)[position];
+  std::span<const int> departures = timetable_.getDepartures(route_id, position);
 
-    // Access arrival seconds at next_stop_id for trip et_id, according to the day
-    int arr_secs = et_day == Day::CurrentDay ? next_stop_time.getArrivalSeconds()
-                                             : next_stop_time.getArrivalSeconds() + MIDNIGHT;
+  int stop_prev_arrival = context.arrivals.getArrival(context.k - 1, pi_stop_id);
 
-    // If arrival time can be improved, update Tk(pj) using et
-    if (improvesArrivalTime(arr_secs, next_stop_id))
-      markStop(next_stop_id, arr_secs, et_id, pi_stop_id);
+  // If stop is not reachable, no trip can be caught
+  if (stop_prev_arrival == UNREACHED) return std::nullopt;
 
-    // Check if an earlier trip can be caught at stop i (because a quicker path was found in a previous round)
-    if ((arrivals_[next_stop_id][k - 1].parent_trip_id.has_value()) // Because we can instantly arrive at source
-        && (arrivals_[next_stop_id][k - 1].arrival_seconds < arr_secs))  // if Tk-1(pi) < Tarr(t, pi)
-      break;
+  // Changing vehicles takes the stop's minimum change time, unless the stop was reached on foot or is the source
+  int change_time = timetable_.getMinChangeTime(pi_stop_id);
+  if (change_time > 0 && context.arrivals.get(context.k - 1, pi_stop_id).parent_trip_id != NO_TRIP) {
+    if (change_time == NO_TRANSFER) return std::nullopt;
+    stop_prev_arrival += change_time;
+  }
 
-  } // end remaining stops on trip et_id
+  // Only trips departing before the target's arrival, and before the current trip, are worth catching
+  int departure_bound = std::numeric_limits<int>::max();
+  if (context.target.has_value())
+    departure_bound = context.arrivals.getArrival(context.k, context.target.value());
+  if (current_trip.has_value())
+    departure_bound = std::min(departure_bound,
+                               departures[current_trip->first - route.first_trip] + current_trip->second * MIDNIGHT);
 
+  return findTripDepartingAfter(context, route_id, position, stop_prev_arrival, departure_bound);
 }
 
-bool Raptor::earlier(int secondsA, std::optional<int> secondsB) {
-  if (!secondsB.has_value()) return true; // if still not set, then any value is better
-  return secondsA < secondsB.value();
-}
+std::optional<std::pair<TripId, int>>
+Raptor::findTripDepartingAfter(const QueryContext &context, RouteId route_id, uint32_t position, int earliest,
+                               int departure_bound) const {
+  const RouteInfo &route = timetable_.getRoute(route_id);
+  std::span<const int> departures = timetable_.getDepartures(route_id, position);
+
+  std::optional<std::pair<TripId, int>> earliest_trip;
+
+  // Trips of an earlier day may still depart after trips of a later day, when their times go past 24:00:00,
+  // so every day is searched, each bounded by the earliest trip found so far
+  for (const auto &[day, period_day]: context.service_days) {
+    int day_offset = day * MIDNIGHT;
+
+    // Days are in increasing order, so if the first trip of the day departs too late, so do those of later days
+    if (departures.front() + day_offset >= departure_bound) break;
 
-bool Raptor::improvesArrivalTime(int arrival, const std::string &dest_id) {
-  return earlier(arrival, arrivals_[dest_id][k].arrival_seconds) // Required
-         && earlier(arrival, arrivals_[query_.target_id][k].arrival_seconds); // Pruning
+    // Departures are sorted, so skip every trip leaving before the stop is reached
+    auto first = std::lower_bound(departures.begin(), departures.end(), earliest - day_offset);
+
+    // The first active trip is the earliest, and every later trip departs later
+    for (auto it = first; it != departures.end() && *it + day_offset < departure_bound; ++it) {
+      auto trip_id = static_cast<TripId>(route.first_trip + (it - departures.begin()));
+      if (!timetable_.isTripActive(trip_id, period_day)) continue;
+
+      earliest_trip = std::make_pair(trip_id, day);
+      departure_bound = *it + day_offset;
+      break;
+    }
+  }
+
+  return earliest_trip;
 }
 
-void Raptor::markStop(const std::string &stop_id, int arrival,
-                      const std::optional<std::string> &parent_trip_id,
-                      const std::optional<std::string> &parent_stop_id) {
-  Day day = arrival > MIDNIGHT ? Day::NextDay : Day::CurrentDay;
-  setMinArrivalTime(stop_id, {arrival, parent_trip_id, parent_stop_id, day});
-  marked_stops.insert(stop_id);
+bool Raptor::improvesArrivalTime(const QueryContext &context, int arrival, StopId dest_id) const {
+  return arrival < context.arrivals.getArrival(context.k, dest_id) // Required
+         && (!context.target.has_value() // Pruning
+             || arrival < context.arrivals.getArrival(context.k, context.target.value()));
+}
 
-//  if ((stop_id == query_.target_id)) {
-//    std::string day_str = Utils::dayToString(day);
-//    std::cout << "Marking " << stop_id << " at " << Utils::secondsToTime(arrival) << day_str <<
-//              " ptrip " << parent_trip_id.value_or("foot") << " from stop "
-//              << parent_stop_id.value_or("none") << " in which we arrive at "
-//              << Utils::secondsToTime(arrivals_[parent_stop_id.value()][k].arrival_seconds.value());
-//    std::cout << std::endl;
-//  }
+void Raptor::markStop(QueryContext &context, StopId stop_id, const StopInfo &stop_info) const {
+  setMinArrivalTime(context, stop_id, stop_info);
+  context.marked_stops.insert(stop_id);
 }
 
 // Updates arrival time of stops that are connected by footpaths
-void Raptor::handleFootpaths() {
+void Raptor::handleFootpaths(QueryContext &context) const {
   // For each previously marked stop p
-  for (const auto &stop_id: prev_marked_stops) {
+  context.prev_marked_stops.forEach([&](StopId stop_id) {
 
-    // If parent step is a footpath, then do not check further footpaths, in order to avoid approximation errors
-    if (isFootpath(arrivals_[stop_id][k - 1])) continue;
+    // Footpaths are transitively closed, so a stop reached on foot has no footpath worth following
+    StopInfo prev_label = context.arrivals.get(context.k - 1, stop_id);
+    if (isFootpath(prev_label)) return;
 
-    std::optional<int> p_prev_arrival = arrivals_[stop_id][k - 1].arrival_seconds;
+    int p_prev_arrival = prev_label.arrival_seconds;
 
     // For each footpath (p, p')
-    for (const auto &[dest_id, duration]: stops_[stop_id].getFootpaths()) {
-      int new_arrival = p_prev_arrival.value() + duration;
-      if (dest_id == query_.target_id && stop_id == "OTH1")
-        std::cout << "from " << stop_id << " to " << dest_id << " with duration " << Utils::secondsToTime(duration)
-                  << " departing at " << Utils::secondsToTime(p_prev_arrival.value())
-                  << " and arriving at " << Utils::secondsToTime(new_arrival) << std::endl;
+    for (const auto &[dest_id, duration]: timetable_.getFootpaths(stop_id)) {
+      int new_arrival = p_prev_arrival + duration;
 
-      if (improvesArrivalTime(new_arrival, dest_id))
-        markStop(dest_id, new_arrival, std::nullopt, stop_id);
+      if (improvesArrivalTime(context, new_arrival, dest_id))
+        markStop(context, dest_id, {new_arrival, NO_TRIP, stop_id});
 
     } // end each footpath (p, p')
-  } // end each marked stop p
+  }); // end each marked stop p
+
+}
+
+void Raptor::scanRouteBags(QueryContext &context, RouteId route_id, uint32_t start) const {
+  std::span<const StopId> route_stops = timetable_.getRouteStops(route_id);
+  const RouteInfo &route = timetable_.getRoute(route_id);
+
+  bool count_agency_changes = context.criteria[static_cast<size_t>(Criterion::AgencyChanges)];
+  bool count_fare_zones = context.criteria[static_cast<size_t>(Criterion::FareZones)];
+
+  // Riding labels hold the departure of their trip from the current stop, which orders them like the trips
+  std::vector<Label> &route_bag = context.route_bag;
+  route_bag.clear();
+
+  for (uint32_t position = start; position < route_stops.size(); ++position) {
+    StopId stop_id = route_stops[position];
+
+    if (!route_bag.empty()) {
+      uint32_t zone = timetable_.getStopZone(stop_id), prev_zone = timetable_.getStopZone(route_stops[position - 1]);
+      bool crosses_zone = count_fare_zones && zone != NO_ZONE && prev_zone != NO_ZONE && zone != prev_zone;
+
+      std::span<const int> departures = timetable_.getDepartures(route_id, position);
+      for (Label &riding: route_bag) {
+        if (crosses_zone) ++riding.fare_zones;
+
+        // Get off at the stop
+        Label label = riding;
+        label.stop_id = stop_id;
+        label.arrival_seconds = timetable_.getTripStopEvents(riding.parent_trip_id)[position].arrival_seconds
+                                + riding.trip_day * MIDNIGHT;
+        insertLabel(context, label);
 
+        riding.arrival_seconds = departures[riding.parent_trip_id - route.first_trip] + riding.trip_day * MIDNIGHT;
+      }
+    }
+
+    // Only labels of the previous round board, since older labels boarded in earlier rounds
+    if (!context.prev_marked_stops.contains(stop_id) || stop_id == context.target) continue;
+    if (position + 1 == route_stops.size()) continue; // No trip departs from the last stop
+
+    for (const auto &[index, parent]: context.bags.getBag(stop_id)) {
+      if (parent.trips != context.k - 1) continue;
+
+      // Changing vehicles takes the stop's minimum change time, unless the stop was reached on foot or is the source
+      int earliest = parent.arrival_seconds;
+      int change_time = timetable_.getMinChangeTime(stop_id);
+      if (change_time > 0 && parent.parent_trip_id != NO_TRIP) {
+        if (change_time == NO_TRANSFER) continue;
+        earliest += change_time;
+      }
+
+      auto trip = findTripDepartingAfter(context, route_id, position, earliest, std::numeric_limits<int>::max());
+      if (!trip.has_value()) continue;
+
+      Label riding = parent;
+      riding.arrival_seconds = timetable_.getDepartures(route_id, position)[trip->first - route.first_trip]
+                               + trip->second * MIDNIGHT;
+      riding.trips = context.k;
+      if (count_agency_changes) {
+        riding.agency_changes += parent.agency != NO_AGENCY && parent.agency != route.agency;
+        riding.agency = route.agency;
+      }
+      riding.parent = index;
+      riding.parent_trip_id = trip->first;
+      riding.boarding_position = position;
+      riding.trip_day = trip->second;
+
+      // Riding labels all have the same agency and number of trips, so a trip leaving no later that is
+      // no worse in the other criteria arrives no later at every later stop, no worse
+      bool dominated = std::ranges::any_of(route_bag, [&riding](const Label &other) {
+        return LabelBags::dominates(other, riding);
+      });
+      if (dominated) continue;
+
+      std::erase_if(route_bag, [&riding](const Label &other) { return LabelBags::dominates(riding, other); });
+      route_bag.push_back(riding);
+    }
+  }
+}
+
+void Raptor::handleFootpathBags(QueryContext &context) const {
+  bool count_walking = context.criteria[static_cast<size_t>(Criterion::WalkingTime)];
+
+  // Stops reached on foot are marked as footpaths are followed, so the stops to extend are set aside first
+  std::vector<StopId> stops;
+  context.marked_stops.forEach([&](StopId stop_id) { stops.push_back(stop_id); });
+
+  std::vector<Label> labels;
+  for (StopId stop_id: stops) {
+    if (stop_id == context.target) continue; // Journeys end at the target
+
+    // Footpaths are transitively closed, so a label reached on foot has no footpath worth following
+    labels.clear();
+    for (const auto &[index, label]: context.bags.getBag(stop_id)) {
+      if (label.trips != context.k || (label.parent != NO_LABEL && label.parent_trip_id == NO_TRIP)) continue;
+
+      Label walked = label;
+      walked.parent = index;
+      labels.push_back(walked);
+    }
+
+    for (const Label &label: labels)
+      for (const auto &[dest_id, duration]: timetable_.getFootpaths(stop_id)) {
+        Label walked = label;
+        walked.stop_id = dest_id;
+        walked.arrival_seconds += duration;
+        if (count_walking) walked.walking_seconds += duration;
+        walked.parent_trip_id = NO_TRIP;
+        walked.boarding_position = 0;
+        walked.trip_day = 0;
+        insertLabel(context, walked);
+      }
+  }
+}
+
+void Raptor::insertLabel(QueryContext &context, Label label) const {
+  if (label.stop_id == context.target) {
+    // Journeys end at the target, so the agency they end with does not matter
+    label.agency = NO_AGENCY;
+  } else if (context.bags.isDominated(context.target.value(), label)) {
+    return;
+  }
+
+  if (context.bags.insert(label).has_value()) context.marked_stops.insert(label.stop_id);
+}
+
+std::ostream &Raptor::log(const QueryContext &context) {
+  // One per thread, since writing to a stream without a buffer sets its state
+  static thread_local std::ostream null_stream(nullptr);
+  return context.verbose ? std::cout : null_stream;
 }
 
 bool Raptor::isFootpath(const StopInfo &stop_info) {
-  return stop_info.parent_stop_id.has_value() && !stop_info.parent_trip_id.has_value();
+  return stop_info.parent_stop_id != NO_STOP && stop_info.parent_trip_id == NO_TRIP;
 }
 
-Journey Raptor::reconstructJourney() {
+Journey Raptor::reconstructJourney(const QueryContext &context, int round) const {
   Journey journey;
-  std::string current_stop_id = query_.target_id;
+  StopId current_stop_id = context.target.value();
 
   while (true) {
 
-    const std::optional<std::string> parent_trip_id_opt = arrivals_[current_stop_id][k].parent_trip_id;
-    std::optional<std::string> parent_agency_name = std::nullopt;
+    StopInfo stop_info = context.arrivals.get(round, current_stop_id);
 
-    const std::optional<std::string> parent_stop_id_opt = arrivals_[current_stop_id][k].parent_stop_id;
+    if (stop_info.parent_stop_id == NO_STOP) break;
 
-    if (!parent_stop_id_opt.has_value()) break;
+    journey.steps.push_back(makeStep(current_stop_id, stop_info));
 
-    const std::string &parent_stop_id = parent_stop_id_opt.value();
+    // Update to the previous stop boarded
+    current_stop_id = stop_info.parent_stop_id;
+  }
 
-    int departure_seconds, duration, arrival_seconds;
-    if (!parent_trip_id_opt.has_value()) { // Footpath
-      arrival_seconds = arrivals_[current_stop_id][k].arrival_seconds.value();
-      duration = stops_[parent_stop_id].getFootpaths().at(current_stop_id);
-      departure_seconds = arrival_seconds - duration;
+  completeJourney(journey);
+  return journey;
+}
 
-    } else { // Trip
-      const std::string &parent_trip_id = parent_trip_id_opt.value();
-      std::string route_id = trips_[parent_trip_id].getField("route_id");
+Journey Raptor::reconstructJourney(const LabelBags &bags, uint32_t label) const {
+  Journey journey;
 
-      std::string agency_id;
-      for (const auto &[key, route]: routes_) {
-        // Check if the first part of the key (route_id) matches
-        if (key.first == route_id) {
-          agency_id = route.getField("agency_id");
-          parent_agency_name = agencies_.at(agency_id).getField("agency_name");
-          break;
-        }
-      }
+  // The parents of a label are never removed from the store, even once they have left their bag
+  for (uint32_t current = label; bags.get(current).parent != NO_LABEL; current = bags.get(current).parent) {
+    const Label &current_label = bags.get(current);
+    StopId parent_stop_id = bags.get(current_label.parent).stop_id;
 
-      departure_seconds = stop_times_[{parent_trip_id, parent_stop_id}].getDepartureSeconds();
-      arrival_seconds = arrivals_[current_stop_id][k].arrival_seconds.value();
-      duration = arrival_seconds - departure_seconds;
-    }
+    journey.steps.push_back(makeStep(current_label.stop_id,
+                                     {current_label.arrival_seconds, current_label.parent_trip_id, parent_stop_id,
+                                      current_label.boarding_position, current_label.trip_day}));
+  }
 
-    Day day = arrival_seconds > MIDNIGHT ? Day::NextDay : Day::CurrentDay;
-    JourneyStep step = {parent_trip_id_opt, parent_agency_name, &stops_[parent_stop_id], &stops_[current_stop_id],
-                        departure_seconds, day, duration, arrival_seconds};
+  completeJourney(journey);
+  return journey;
+}
 
-    journey.steps.push_back(step);
+JourneyStep Raptor::makeStep(StopId stop_id, const StopInfo &stop_info) const {
+  AgencyId parent_agency_id = NO_AGENCY;
 
-    // Update to the previous stop boarded
-    current_stop_id = parent_stop_id;
+  StopId parent_stop_id = stop_info.parent_stop_id;
+
+  int departure_seconds, duration;
+  int arrival_seconds = stop_info.arrival_seconds;
+  if (stop_info.parent_trip_id == NO_TRIP) { // Footpath
+    std::span<const Footpath> footpaths = timetable_.getFootpaths(parent_stop_id);
+    auto footpath = std::lower_bound(footpaths.begin(), footpaths.end(), stop_id,
+                                     [](const Footpath &f, StopId stop_id) { return f.to < stop_id; });
+    duration = footpath->duration;
+    departure_seconds = arrival_seconds - duration;
+
+  } else { // Trip
+    TripId trip_id = stop_info.parent_trip_id;
+    parent_agency_id = timetable_.getTripAgency(trip_id);
+
+    departure_seconds = timetable_.getTripStopEvents(trip_id)[stop_info.boarding_position].departure_seconds
+                        + stop_info.trip_day * MIDNIGHT;
+    duration = arrival_seconds - departure_seconds;
   }
 
+  // Arrivals at midnight sharp are still on the day before
+  auto day = static_cast<Day>(arrival_seconds > MIDNIGHT ? (arrival_seconds - 1) / MIDNIGHT : 0);
+  return {stop_info.parent_trip_id, parent_agency_id, parent_stop_id, stop_id, departure_seconds, day, duration,
+          arrival_seconds};
+}
+
+void Raptor::completeJourney(Journey &journey) {
   // Reverse the journey to obtain the correct sequence
   std::reverse(journey.steps.begin(), journey.steps.end());
 
+  if (journey.steps.empty()) return;
+
   // Set journey departure secs and day
   journey.departure_secs = journey.steps.front().departure_secs;
   journey.departure_day = journey.steps.front().day;
@@ -532,80 +936,84 @@ Journey Raptor::reconstructJourney() {
 
   // Set journey duration
   journey.duration = journey.arrival_secs - journey.departure_secs;
+}
 
-  return journey;
+bool Raptor::isValidJourney(const Journey &journey) const {
+  return isValidJourney(journey, context_);
 }
 
-bool Raptor::isValidJourney(Journey journey) const {
-  if (journey.steps.empty() ||
-      (journey.steps.front().src_stop->getField("stop_id") != query_.source_id))
+bool Raptor::isValidJourney(const Journey &journey, const QueryContext &context) const {
+  if (journey.steps.empty() || journey.steps.front().src_stop != context.source)
     return false;
 
   return true;
 }
 
-const std::unordered_map<std::string, Stop> &Raptor::getStops() const {
-  return stops_;
+const Timetable &Raptor::getTimetable() const {
+  return timetable_;
 }
 
-void Raptor::showJourney(const Journey &journey) {
+void Raptor::showJourney(const Journey &journey) const {
+  // Format into a local stream, since the width set on std::cout would be shared by concurrent queries
+  std::ostringstream out;
+  out.flags(std::cout.flags());
 
   // Print the header row
-  std::cout << std::setw(5) << "step" << std::setw(8) << "day"
-            << std::setw(10) << "dep_time " << std::setw(8) << "stop " << std::setw(14) << "(name)"
-            << std::setw(10) << "duration "
-            << std::setw(8) << "-> stop " << std::setw(14) << "(name)" << std::setw(9) << "arr_time "
-            << std::setw(14) << " trip "
-            << std::setw(7) << "agency" << std::endl;
+  out << std::setw(5) << "step" << std::setw(8) << "day"
+      << std::setw(10) << "dep_time " << std::setw(8) << "stop " << std::setw(14) << "(name)"
+      << std::setw(10) << "duration "
+      << std::setw(8) << "-> stop " << std::setw(14) << "(name)" << std::setw(9) << "arr_time "
+      << std::setw(14) << " trip "
+      << std::setw(7) << "agency" << std::endl;
 
   // Print the journey steps
   for (int j = 0; j < journey.steps.size(); j++) {
     const JourneyStep &step = journey.steps[j];
 
-    std::cout << std::setw(5) << j + 1;
+    out << std::setw(5) << j + 1;
 
     std::string day = Utils::dayToString(step.day);
-    std::cout << std::setw(8) << day;
-
-    std::cout << std::setw(10) << Utils::secondsToTime(step.departure_secs)
-              << std::setw(8) << step.src_stop->getField("stop_id")
-              << std::setw(14) << Utils::getFirstWord(step.src_stop->getField("stop_name"))
-              << std::setw(10) << Utils::secondsToTime(step.duration)
-              << std::setw(8) << step.dest_stop->getField("stop_id")
-              << std::setw(14) << Utils::getFirstWord(step.dest_stop->getField("stop_name"))
-              << std::setw(10) << Utils::secondsToTime(step.arrival_secs);
-
-    if (step.trip_id.has_value()) {
-      std::cout << std::setw(13) << step.trip_id.value();
-      std::cout << std::setw(7) << Utils::getFirstWord(step.agency_name.value());
+    out << std::setw(8) << day;
+
+    out << std::setw(10) << Utils::secondsToTime(step.departure_secs)
+        << std::setw(8) << timetable_.getStopId(step.src_stop)
+        << std::setw(14) << Utils::getFirstWord(std::string(timetable_.getStopName(step.src_stop)))
+        << std::setw(10) << Utils::secondsToTime(step.duration)
+        << std::setw(8) << timetable_.getStopId(step.dest_stop)
+        << std::setw(14) << Utils::getFirstWord(std::string(timetable_.getStopName(step.dest_stop)))
+        << std::setw(10) << Utils::secondsToTime(step.arrival_secs);
+
+    if (step.trip_id != NO_TRIP) {
+      out << std::setw(13) << timetable_.getTripId(step.trip_id);
+      out << std::setw(7) << Utils::getFirstWord(std::string(timetable_.getAgencyName(step.agency_id)));
     } else
-      std::cout << std::setw(12) << "footpath";
+      out << std::setw(12) << "footpath";
 
 
-    std::cout << std::endl << std::endl;
+    out << std::endl << std::endl;
   }
-}
 
-bool Raptor::isDominatedByAny(const std::vector<Journey> &journeys, const Journey &journey) {
-  return std::ranges::any_of(journeys, [&journey](const Journey &otherJourney) {
-    return dominates(otherJourney, journey);
-  });
+  std::cout << out.str();
 }
 
 void Raptor::keepParetoOptimal(std::vector<Journey> &journeys) {
-  journeys.erase(std::remove_if(journeys.begin(), journeys.end(),
-                                [&journeys](const Journey &journey) {
-                                  return isDominatedByAny(journeys, journey);
-                                }),
-                 journeys.end());
-}
-
-// Keeps only the Pareto-optimal journeys
-bool Raptor::dominates(const Journey &journey1, const Journey &journey2) {
-  // If two journeys have the same number of steps, keep the one with the earliest arrival time
-  // If a journey has more steps but not better arrival time, discard it
-  return ((journey1.duration < journey2.duration
-           && journey1.steps.size() <= journey2.steps.size())
-          || (journey1.steps.size() < journey2.steps.size()
-              && journey1.duration <= journey2.duration));
+  ParetoSet<Journey, JourneyTraits> optimal;
+  for (Journey &journey: journeys) optimal.insert(std::move(journey));
+  journeys = optimal.release();
+}
+
+void Raptor::keepProfileParetoOptimal(std::vector<Journey> &journeys) {
+  // Latest departure first, then earliest arrival, then fewest steps, so that a journey can only be
+  // dominated by a journey kept before it, and journeys equal in all three criteria keep the first
+  std::sort(journeys.begin(), journeys.end(), [](const Journey &journey1, const Journey &journey2) {
+    if (journey1.departure_secs != journey2.departure_secs) return journey1.departure_secs > journey2.departure_secs;
+    if (journey1.arrival_secs != journey2.arrival_secs) return journey1.arrival_secs < journey2.arrival_secs;
+    return journey1.steps.size() < journey2.steps.size();
+  });
+
+  ParetoSet<Journey, ProfileJourneyTraits> optimal;
+  for (Journey &journey: journeys) optimal.insert(std::move(journey));
+
+  journeys = optimal.release();
+  std::reverse(journeys.begin(), journeys.end());
 }
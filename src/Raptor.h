@@ -19,16 +19,23 @@
 #include <iostream>
 #include <vector>
 #include <iomanip>  // for setw
+#include <array>
 #include "Parser.h"
 #include "Utils.h"
+#include "NetworkObjects/Timetable.h"
+#include "NetworkObjects/SpatialGrid.h"
+#include "QueryContext.h"
 
 /**
  * @class Raptor
  * @brief Implements the RAPTOR algorithm for finding Pareto-optimal journeys.
  *
  * The Raptor class provides methods to set a query, find Pareto-optimal journeys,
- * and print journey steps. It uses various data structures to store information
- * about agencies, calendars, stops, routes, trips, and stop times.
+ * and print journey steps. The parsed GTFS data is compiled into a Timetable,
+ * on which the rounds of the algorithm run.
+ *
+ * The const query methods keep their state in a QueryContext, so several threads may answer queries
+ * at once, each with its own context. The other query methods use a context owned by the Raptor object.
  */
 class Raptor {
 public:
@@ -43,24 +50,23 @@ public:
   /**
    * @brief Parameterized constructor for Raptor.
    *
-   * Initializes the Raptor object with provided agency, calendar, stop, route, trip, and stop time data.
+   * Generates the footpaths between the stops of a parsed feed, and compiles it into a Timetable.
+   *
+   * @param[in] feed The tables of the GTFS feeds, with stop times grouped by trip.
+   * @param[in] max_walking_duration The longest footpath to generate between stops, in seconds,
+   *            or `std::nullopt` to connect every pair of stops.
+   */
+  explicit Raptor(const GTFSFeed &feed, std::optional<int> max_walking_duration = std::nullopt);
+
+  /**
+   * @brief Constructs a Raptor object over an already compiled timetable.
    *
-   * @param[in] agencies_ A map of agency IDs to Agency objects.
-   * @param[in] calendars_ A map of calendar IDs to Calendar objects.
-   * @param[in] stops A map of stop IDs to Stop objects.
-   * @param[in] routes A map of pairs of route IDs and direction IDs to Route objects.
-   * @param[in] trips A map of trip IDs to Trip objects.
-   * @param[in] stop_times A map of pairs of trip IDs and stop IDs to StopTime objects.
+   * @param[in] timetable The timetable, e.g. loaded from a binary snapshot.
    */
-  Raptor(const std::unordered_map<std::string, Agency> &agencies_,
-         const std::unordered_map<std::string, Calendar> &calendars_,
-         const std::unordered_map<std::string, Stop> &stops,
-         const std::unordered_map<std::pair<std::string, std::string>, Route, pair_hash> &routes,
-         const std::unordered_map<std::string, Trip> &trips,
-         const std::unordered_map<std::pair<std::string, std::string>, StopTime, pair_hash> &stop_times);
+  explicit Raptor(Timetable timetable);
 
   /**
-   * @brief Sets the query for the Raptor algorithm.
+   * @brief Sets the query answered by the methods that use the Raptor object's own context.
    *
    * @param[in] query The query containing the parameters for journey search.
    */
@@ -72,9 +78,113 @@ public:
    * This function uses the RAPTOR algorithm to compute all optimal journeys based on the provided query.
    *
    * @return A vector of Journey objects representing the Pareto-optimal journeys.
+   * @throws std::runtime_error If a stop ID of the query is unknown.
    */
   std::vector<Journey> findJourneys();
 
+  /**
+   * @brief Finds all Pareto-optimal journeys of the query of a context.
+   *
+   * @param[in,out] context The scratch state of the query, whose query must be set.
+   * @return A vector of Journey objects representing the Pareto-optimal journeys.
+   * @throws std::runtime_error If a stop ID of the query is unknown.
+   */
+  std::vector<Journey> findJourneys(QueryContext &context) const;
+
+  /**
+   * @brief Finds the Pareto-optimal journeys departing within a time window (rRAPTOR).
+   *
+   * The window starts at the query's departure time and ends at its latest departure time.
+   * The rounds are run once per distinct departure from the source, latest first, keeping the labels
+   * of later departures as upper bounds, so each run only explores what an earlier departure improves.
+   *
+   * @return The journeys that no other journey leaves later than, arrives earlier than and has fewer steps than,
+   *         sorted by departure.
+   * @throws std::runtime_error If a stop ID of the query is unknown.
+   */
+  std::vector<Journey> findProfileJourneys();
+
+  /**
+   * @brief Finds the Pareto-optimal journeys of the query of a context, departing within its time window.
+   *
+   * @param[in,out] context The scratch state of the query, whose query must be set.
+   * @return The journeys of the profile, sorted by departure.
+   * @throws std::runtime_error If a stop ID of the query is unknown.
+   */
+  std::vector<Journey> findProfileJourneys(QueryContext &context) const;
+
+  /**
+   * @brief Finds the Pareto-optimal journeys under the criteria of the query (McRAPTOR).
+   *
+   * Besides arrival time and number of trips, journeys are compared by the criteria of the query, so that
+   * e.g. a journey walking less is kept even if it arrives later. Each stop keeps a bag of labels
+   * that no other label of the stop dominates, instead of a single arrival time per round.
+   *
+   * @return The journeys that no other journey is at least as good as in every criterion, by arrival time.
+   * @throws std::runtime_error If the query has no target, or a stop ID of the query is unknown.
+   */
+  std::vector<Journey> findMultiCriteriaJourneys();
+
+  /**
+   * @brief Finds the Pareto-optimal journeys of the query of a context under its criteria.
+   *
+   * @param[in,out] context The scratch state of the query, whose query must be set.
+   * @return The journeys, by arrival time.
+   * @throws std::runtime_error If the query has no target, or a stop ID of the query is unknown.
+   */
+  std::vector<Journey> findMultiCriteriaJourneys(QueryContext &context) const;
+
+  /**
+   * @brief Finds the earliest arrival at every stop (one-to-all).
+   *
+   * The query's target is ignored, so no label is pruned by it.
+   *
+   * @return The earliest arrival at each stop after each round, i.e. using at most that many trips.
+   * @throws std::runtime_error If the source stop ID of the query is unknown.
+   */
+  RoundArrivals findAllArrivals();
+
+  /**
+   * @brief Finds the earliest arrival at every stop from the source of the query of a context.
+   *
+   * @param[in,out] context The scratch state of the query, whose query must be set.
+   * @return The earliest arrival at each stop after each round.
+   * @throws std::runtime_error If the source stop ID of the query is unknown.
+   */
+  RoundArrivals findAllArrivals(QueryContext &context) const;
+
+  /**
+   * @brief Finds the earliest arrivals between many sources and many targets (many-to-many).
+   *
+   * Runs one one-to-all query per source. The current query is replaced.
+   *
+   * @param[in] source_ids The IDs of the source stops.
+   * @param[in] target_ids The IDs of the target stops.
+   * @param[in] date The date of the journeys.
+   * @param[in] departure_time The departure time from every source.
+   * @return The earliest arrival at each target (inner) from each source (outer), or `std::nullopt` if unreachable.
+   * @throws std::runtime_error If a stop ID is unknown.
+   */
+  std::vector<std::vector<std::optional<int>>> findArrivalMatrix(const std::vector<std::string> &source_ids,
+                                                                 const std::vector<std::string> &target_ids,
+                                                                 const Date &date, const Time &departure_time);
+
+  /**
+   * @brief Finds the earliest arrivals between many sources and many targets, using a given context.
+   *
+   * @param[in] source_ids The IDs of the source stops.
+   * @param[in] target_ids The IDs of the target stops.
+   * @param[in] date The date of the journeys.
+   * @param[in] departure_time The departure time from every source.
+   * @param[in,out] context The scratch state of the queries, whose query is replaced.
+   * @return The earliest arrival at each target (inner) from each source (outer), or `std::nullopt` if unreachable.
+   * @throws std::runtime_error If a stop ID is unknown.
+   */
+  std::vector<std::vector<std::optional<int>>> findArrivalMatrix(const std::vector<std::string> &source_ids,
+                                                                 const std::vector<std::string> &target_ids,
+                                                                 const Date &date, const Time &departure_time,
+                                                                 QueryContext &context) const;
+
   /**
   * @brief Displays the steps of a journey.
   *
@@ -82,14 +192,14 @@ public:
   *
   * @param[in] journey The Journey object to be displayed.
   */
-  static void showJourney(const Journey &journey);
+  void showJourney(const Journey &journey) const;
 
   /**
-   * @brief Gets the stops in the system.
+   * @brief Gets the timetable the algorithm runs on.
    *
-   * @return A reference to the map of stop IDs to Stop objects.
+   * @return A constant reference to the Timetable.
    */
-  const std::unordered_map<std::string, Stop> &getStops() const;
+  const Timetable &getTimetable() const;
 
   /**
    * @brief Validates if the given journey is valid.
@@ -99,140 +209,206 @@ public:
    * @param[in] journey The Journey object to be validated.
    * @return True if the journey is valid, false otherwise.
    */
-  bool isValidJourney(Journey journey) const;
+  bool isValidJourney(const Journey &journey) const;
+
+  /**
+   * @brief Validates if the given journey is valid for the query of a context.
+   *
+   * @param[in] journey The Journey object to be validated.
+   * @param[in] context The scratch state of the query the journey was found for.
+   * @return True if the journey is valid, false otherwise.
+   */
+  bool isValidJourney(const Journey &journey, const QueryContext &context) const;
 
 private:
 
-  std::unordered_map<std::string, Agency> agencies_; ///< Map of agency IDs to Agency objects.
-  std::unordered_map<std::string, Calendar> calendars_; ///< Map of service IDs to Calendar objects.
-  std::unordered_map<std::string, Stop> stops_; ///< Map of stop IDs to Stop objects.
-  std::unordered_map<std::pair<std::string, std::string>, Route, pair_hash> routes_; ///< Map of route keys to Route objects.
-  std::unordered_map<std::string, Trip> trips_; ///< Map of trip IDs to Trip objects.
-  std::unordered_map<std::pair<std::string, std::string>, StopTime, pair_hash> stop_times_; ///< Map of stop time keys to StopTime objects.
+  Timetable timetable_; ///< Dense timetable the rounds run on.
 
-  Query query_; ///< The current query for the RAPTOR algorithm.
-  std::unordered_map<std::string, std::vector<StopInfo>> arrivals_; ///< Map of stop IDs to vectors of StopInfo for each k.
-  std::unordered_set<std::string> prev_marked_stops; ///< Set of previously marked stops.
-  std::unordered_set<std::string> marked_stops; ///< Set of currently marked stops.
-  int k{}; ///< The current round of the algorithm.
+  QueryContext context_; ///< Scratch state of the query set with setQuery().
 
   /**
-   * @brief Initializes the footpaths between stops.
+   * @brief Initializes the footpaths between stops that are within walking distance.
+   *
+   * If the walking duration is bounded, only the stops in neighbouring cells of a SpatialGrid are compared,
+   * and the footpaths, with the transfers of the feed between different stops, are then transitively closed:
+   * every stop reachable by a chain of footpaths within the bound gets a direct footpath, the duration of
+   * the shortest chain. The stops of a transfer keep its own duration, or stay apart if it is not possible.
+   *
+   * Without a bound, every pair of stops is connected already, and the graph is not closed: a walk following
+   * a transfer shorter than the walk between its stops is not found.
+   *
+   * @param[in] feed The feed, whose stops and transfers are used.
+   * @param[in] max_walking_duration The longest footpath to generate in seconds, or `std::nullopt` for no limit.
+   * @return The footpaths from each stop row, to other stop rows.
    */
-  void initializeFootpaths();
+  static std::vector<std::vector<Footpath>> initializeFootpaths(const GTFSFeed &feed,
+                                                                std::optional<int> max_walking_duration);
 
   /**
    * @brief Initializes the algorithm by setting required parameters.
+   *
+   * @param[in,out] context The scratch state of the query.
+   * @param[in] ignore_target True for one-to-all queries, which leave the target unset whatever the query's.
+   * @throws std::runtime_error If the source stop ID, or the target stop ID unless ignored, is unknown.
    */
-  void initializeAlgorithm();
+  void initializeAlgorithm(QueryContext &context, bool ignore_target = false) const;
 
   /**
-   * @brief Sets the minimum arrival time for a given stop.
+   * @brief Runs the rounds for one departure from the source.
+   *
+   * Labels of previous runs are kept, and only improved upon. Journeys are only reconstructed
+   * once the rounds are over, from the labels of the rounds in which the target improved.
    *
-   * @param[in] stop_id The ID of the stop.
-   * @param[in] stop_info The stop info containing the arrival time, parent trip ID, and parent stop ID.
+   * @param[in,out] context The scratch state of the query.
+   * @param[in] departure The departure time from the source, in seconds.
+   * @return The journeys that improved the arrival at the target, one per round at most.
    */
-  void setMinArrivalTime(const std::string &stop_id, StopInfo stop_info);
+  std::vector<Journey> runRounds(QueryContext &context, int departure) const;
 
   /**
-   * @brief Fills the active trips for a given day.
+   * @brief Collects the departure times of a profile query.
    *
-   * @param[in] day The day for which trips are being filled.
+   * These are the departures of active trips from the source, and from the stops within walking distance
+   * of the source shifted by the walk, within the window, plus the end of the window.
+   *
+   * @param[in] context The scratch state of the query.
+   * @param[in] earliest The start of the window, in seconds.
+   * @param[in] latest The end of the window, in seconds.
+   * @return The distinct departure times, latest first.
    */
-  void fillActiveTrips(Day day);
+  std::vector<int> collectDepartures(const QueryContext &context, int earliest, int latest) const;
 
   /**
-   * @brief Sets the upper bound for the search, based on previous round.
+   * @brief Sets the minimum arrival time for a given stop.
+   *
+   * @param[in,out] context The scratch state of the query.
+   * @param[in] stop_id The index of the stop.
+   * @param[in] stop_info The stop info containing the arrival time, parent trip, and parent stop.
    */
-  void setUpperBound();
+  void setMinArrivalTime(QueryContext &context, StopId stop_id, const StopInfo &stop_info) const;
 
   /**
-   * @brief Accumulates routes serving each stop.
+   * @brief Accumulates routes serving each marked stop.
    *
-   * @return A set of routes that serve stops.
+   * Queues each route once, with the position of the earliest marked stop it serves.
+   *
+   * @param[in,out] context The scratch state of the query.
    */
-  std::unordered_set<std::pair<std::pair<std::string, std::string>, std::string>, nested_pair_hash>
-  accumulateRoutesServingStops();
+  void accumulateRoutesServingStops(QueryContext &context) const;
 
   /**
-   * @brief Traverses the routes serving each stop.
+   * @brief Traverses the queued routes, from their earliest marked stop, and empties the queue.
    *
-   * @param[in] routes_stops_set The set of routes and stops to be traversed.
+   * @param[in,out] context The scratch state of the query.
    */
-  void traverseRoutes(
-          std::unordered_set<std::pair<std::pair<std::string, std::string>, std::string>, nested_pair_hash> routes_stops_set);
+  void traverseRoutes(QueryContext &context) const;
 
   /**
-   * @brief Finds the earliest trip for a given stop and route.
+   * @brief Scans a route once, from a given stop to its end.
+   *
+   * Arrival times are updated with the current trip, and an earlier trip is looked up
+   * at every stop reached in the previous round.
    *
-   * @param[in] pi_stop_id The ID of the stop.
-   * @param[in] route_key The key consisting of route and direction.
-   * @return An optional pair of trip ID and day if found.
+   * @param[in,out] context The scratch state of the query.
+   * @param[in] route_id The index of the route.
+   * @param[in] start The position in the route of the first stop to scan.
    */
-  std::optional<std::pair<std::string, Day>>
-  findEarliestTrip(const std::string &pi_stop_id, const std::pair<std::string, std::string> &route_key);
+  void scanRoute(QueryContext &context, RouteId route_id, uint32_t start) const;
 
   /**
-   * @brief Checks if a trip is valid based on the route and stop time.
+   * @brief Finds the earliest trip of a route that can be caught at a given stop of the route.
+   *
+   * The departures of the route are binary searched. Only trips that depart before
+   * the current trip, if any, and before the target's arrival are considered.
    *
-   * @param[in] route_key The key consisting of route and direction.
-   * @param[in] stop_time The stop time for the trip.
-   * @param[in] day The day to check the trip against.
-   * @return True if the trip is valid, false otherwise.
+   * @param[in] context The scratch state of the query.
+   * @param[in] route_id The index of the route.
+   * @param[in] position The position of the stop in the route.
+   * @param[in] current_trip The trip currently ridden on the route, if any.
+   * @return An optional pair of trip index and service day, in days from the query date, if found.
    */
-  bool isValidTrip(const std::pair<std::string, std::string> &route_key, const StopTime &stop_time, const Day &day);
+  std::optional<std::pair<TripId, int>>
+  findEarliestTrip(const QueryContext &context, RouteId route_id, uint32_t position,
+                   const std::optional<std::pair<TripId, int>> &current_trip = std::nullopt) const;
 
   /**
-   * @brief Checks if the service is active based on the calendar and date.
+   * @brief Finds the first active trip of a route departing from one of its stops within a time interval.
    *
-   * @param[in] calendar The calendar object containing service dates.
-   * @param[in] date The date to check.
-   * @return True if the service is active on the given date, false otherwise.
+   * @param[in] context The scratch state of the query.
+   * @param[in] route_id The index of the route.
+   * @param[in] position The position of the stop in the route.
+   * @param[in] earliest The earliest departure, in seconds from the query date.
+   * @param[in] departure_bound The departure the trip must leave before, in seconds from the query date.
+   * @return An optional pair of trip index and service day, in days from the query date, if found.
    */
-  static bool isServiceActive(const Calendar &calendar, const Date &date);
+  std::optional<std::pair<TripId, int>>
+  findTripDepartingAfter(const QueryContext &context, RouteId route_id, uint32_t position, int earliest,
+                         int departure_bound) const;
 
   /**
-   * @brief Traverses a specific trip.
+   * @brief Scans a route once for a multi-criteria query, from a given stop to its end.
    *
-   * @param[in,out] et_id The trip ID.
-   * @param[in,out] et_day The day of travel.
-   * @param[in,out] pi_stop_id The stop ID for the trip.
+   * The labels riding the route get off at every stop, and the labels of the previous round at a stop
+   * board the earliest trip they can catch there.
+   *
+   * @param[in,out] context The scratch state of the query.
+   * @param[in] route_id The index of the route.
+   * @param[in] start The position in the route of the first stop to scan.
    */
-  void traverseTrip(std::string &et_id, Day &et_day, std::string &pi_stop_id);
+  void scanRouteBags(QueryContext &context, RouteId route_id, uint32_t start) const;
 
   /**
-   * @brief Compares two arrival times to determine which is earlier.
+   * @brief Extends the labels reached by a trip in the current round of a multi-criteria query with footpaths.
+   *
+   * In round 0, the source label is extended instead.
    *
-   * @param[in] secondsA The first arrival time in seconds.
-   * @param[in] secondsB The second arrival time in seconds.
-   * @return True if the first arrival time is earlier, false otherwise.
+   * @param[in,out] context The scratch state of the query.
    */
-  static bool earlier(int secondsA, std::optional<int> secondsB);
+  void handleFootpathBags(QueryContext &context) const;
+
+  /**
+   * @brief Adds a label to the bag of its stop, and marks the stop, unless the label is dominated.
+   *
+   * Labels dominated by a label of the target are discarded too, since extending a label never improves it.
+   *
+   * @param[in,out] context The scratch state of the query.
+   * @param[in] label The label.
+   */
+  void insertLabel(QueryContext &context, Label label) const;
 
   /**
    * @brief Checks if a step improves the arrival time for a destination.
    *
+   * @param[in] context The scratch state of the query.
    * @param[in] arrival The arrival time.
-   * @param[in] dest_id The destination stop ID.
+   * @param[in] dest_id The destination stop index.
    * @return True if the arrival time improves, false otherwise.
    */
-  bool improvesArrivalTime(int arrival, const std::string &dest_id);
+  bool improvesArrivalTime(const QueryContext &context, int arrival, StopId dest_id) const;
 
   /**
    * @brief Marks a stop with the arrival time, parent trip, and parent stop.
    *
-   * @param[in] stop_id The ID of the stop.
-   * @param[in] arrival The arrival time at the stop.
-   * @param[in] parent_trip_id The ID of the parent trip.
-   * @param[in] parent_stop_id The ID of the parent stop.
+   * @param[in,out] context The scratch state of the query.
+   * @param[in] stop_id The index of the stop.
+   * @param[in] stop_info The label of the stop, with its arrival time and parents.
    */
-  void markStop(const std::string &stop_id, int arrival,
-                const std::optional<std::string> &parent_trip_id, const std::optional<std::string> &parent_stop_id);
+  void markStop(QueryContext &context, StopId stop_id, const StopInfo &stop_info) const;
 
   /**
    * @brief Handles footpath logic during traversal.
+   *
+   * @param[in,out] context The scratch state of the query.
    */
-  void handleFootpaths();
+  void handleFootpaths(QueryContext &context) const;
+
+  /**
+   * @brief Gets the stream the progress of a query is written to.
+   *
+   * @param[in] context The scratch state of the query.
+   * @return std::cout if the query is verbose, otherwise a stream that discards its output.
+   */
+  static std::ostream &log(const QueryContext &context);
 
   /**
    * @brief Checks if the given stop info represents a footpath.
@@ -243,37 +419,56 @@ private:
   static bool isFootpath(const StopInfo &stop_info);
 
   /**
-   * @brief Reconstructs the journey based on the current round.
+   * @brief Reconstructs the journey reaching the target in a round, by following the parents of its labels.
    *
+   * @param[in] context The scratch state of the query.
+   * @param[in] round The round, in which the target was improved.
    * @return A Journey object representing the reconstructed journey.
    */
-  Journey reconstructJourney();
+  Journey reconstructJourney(const QueryContext &context, int round) const;
 
   /**
-   * Checks if a given journey is dominated by any other journey in the list.
+   * @brief Reconstructs the journey of a label of a multi-criteria query, by following its parents.
    *
-   * @param journeys A list of all journeys to compare against.
-   * @param journey The journey to check.
-   * @return True if the journey is dominated, otherwise false.
+   * @param[in] bags The labels of the query.
+   * @param[in] label The index of the label.
+   * @return A Journey object representing the reconstructed journey.
    */
-  static bool isDominatedByAny(const std::vector<Journey> &journeys, const Journey &journey);
+  Journey reconstructJourney(const LabelBags &bags, uint32_t label) const;
 
   /**
-   * @brief Keeps the Pareto-optimal journeys from a list of journeys.
+   * @brief Builds the step of a journey that reaches a stop.
    *
-   * @param[in] journeys The list of journeys to be filtered.
-   * @return A list of Pareto-optimal journeys.
+   * @param[in] stop_id The index of the stop reached.
+   * @param[in] stop_info The label of the stop, with a parent stop.
+   * @return The step, by trip or footpath from the parent stop.
+   */
+  JourneyStep makeStep(StopId stop_id, const StopInfo &stop_info) const;
+
+  /**
+   * @brief Puts the steps of a journey in order, and sets its departure, arrival and duration.
+   *
+   * @param[in,out] journey The journey, with its steps from the last to the first.
+   */
+  static void completeJourney(Journey &journey);
+
+  /**
+   * @brief Keeps the journeys that are Pareto-optimal in duration and number of steps.
+   *
+   * Journeys equal in both criteria are all kept.
+   *
+   * @param[in,out] journeys The journeys to be filtered, sorted by number of steps on return.
    */
   static void keepParetoOptimal(std::vector<Journey> &journeys);
 
   /**
-   * @brief Compares two journeys to check if one dominates the other.
+   * @brief Keeps the journeys of a profile that are Pareto-optimal in departure, arrival and number of steps.
+   *
+   * Of journeys equal in all three criteria, only one is kept.
    *
-   * @param[in] journey1 The first journey to be compared.
-   * @param[in] journey2 The second journey to be compared.
-   * @return True if the first journey dominates the second, false otherwise.
+   * @param[in,out] journeys The journeys to be filtered, sorted by departure on return.
    */
-  static bool dominates(const Journey &journey1, const Journey &journey2);
+  static void keepProfileParetoOptimal(std::vector<Journey> &journeys);
 };
 
 #endif //RAPTOR_RAPTOR_H
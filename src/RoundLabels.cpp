@@ -0,0 +1,68 @@
+/**
+ * @file RoundLabels.cpp
+ * @brief RoundLabels class implementation
+ *
+ * This file contains the implementation of the RoundLabels class, which stores
+ * the labels of a RAPTOR query per round, and resets them lazily between queries.
+ */
+
+#include "RoundLabels.h"
+
+void RoundLabels::reset(size_t num_stops) {
+  // A context reused on another timetable starts over
+  if (num_stops != num_stops_) {
+    num_stops_ = num_stops;
+    arrivals_.clear();
+    parents_.clear();
+    stop_rounds_.assign(num_stops, {0, 0});
+  }
+
+  // Once the epochs wrap around, stamps of old queries could match again
+  if (++epoch_ == 0) {
+    for (Arrival &arrival: arrivals_) arrival.epoch = 0;
+    for (StopRounds &stop_rounds: stop_rounds_) stop_rounds.epoch = 0;
+    epoch_ = 1;
+  }
+}
+
+StopInfo RoundLabels::get(int round, StopId stop_id) const {
+  size_t i = find(round, stop_id);
+  if (i == NOT_FOUND) return {};
+
+  const Parent &parent = parents_[i];
+  return {arrivals_[i].seconds, parent.trip_id, parent.stop_id, parent.boarding_position, parent.trip_day};
+}
+
+void RoundLabels::set(int round, StopId stop_id, const StopInfo &stop_info) {
+  // Rounds are allocated on first use, and kept for the next queries
+  if (round >= numRounds()) {
+    arrivals_.resize((round + 1) * num_stops_, {0, UNREACHED});
+    parents_.resize((round + 1) * num_stops_);
+  }
+
+  StopRounds &stop_rounds = stop_rounds_[stop_id];
+  if (stop_rounds.epoch != epoch_) stop_rounds = {epoch_, round};
+
+  Parent parent = {stop_info.parent_trip_id, stop_info.parent_stop_id, stop_info.boarding_position,
+                   stop_info.trip_day};
+
+  size_t i = static_cast<size_t>(round) * num_stops_ + stop_id;
+  arrivals_[i] = {epoch_, stop_info.arrival_seconds};
+  parents_[i] = parent;
+
+  // Labels of later rounds are never later, so the first one not later than this one ends the replacement
+  for (int r = round + 1; r <= stop_rounds.last_round; ++r) {
+    size_t j = static_cast<size_t>(r) * num_stops_ + stop_id;
+    if (arrivals_[j].epoch != epoch_) continue;
+    if (arrivals_[j].seconds <= stop_info.arrival_seconds) break;
+
+    arrivals_[j].seconds = stop_info.arrival_seconds;
+    parents_[j] = parent;
+  }
+
+  stop_rounds.last_round = std::max(stop_rounds.last_round, round);
+}
+
+int RoundLabels::numRounds() const {
+  return num_stops_ == 0 ? 0 : static_cast<int>(arrivals_.size() / num_stops_);
+}
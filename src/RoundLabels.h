@@ -0,0 +1,136 @@
+/**
+ * @file RoundLabels.h
+ * @brief Defines the RoundLabels class, the labels of every stop in every round of a RAPTOR query.
+ *
+ * This header file declares the RoundLabels class, which keeps the labels of all rounds in flat
+ * arrays, reused from query to query without being cleared.
+ */
+
+#ifndef RAPTOR_ROUNDLABELS_H
+#define RAPTOR_ROUNDLABELS_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+
+#include "NetworkObjects/DataStructures.h"
+
+/**
+ * @class RoundLabels
+ * @brief The StopInfo of each stop after each round, stored as rounds × stops arrays.
+ *
+ * A label is only written in the rounds in which its stop improves, and reading a round yields the latest
+ * label written at or before it, so labels are never copied from round to round.
+ * Every label is stamped with the epoch of the query that wrote it, and labels of older epochs read as unset:
+ * starting a query costs one increment instead of clearing the arrays.
+ *
+ * The arrival times and epochs scanned by every round are kept apart from the parents,
+ * which are only read to reconstruct journeys.
+ */
+class RoundLabels {
+public:
+  /**
+   * @brief Starts a query, which sees every label as unset.
+   *
+   * @param[in] num_stops The number of stops of the timetable queried.
+   */
+  void reset(size_t num_stops);
+
+  /**
+   * @brief Gets the arrival time at a stop after a round.
+   *
+   * @param[in] round The round.
+   * @param[in] stop_id The index of the stop.
+   * @return The arrival time of the latest label of the stop written at or before the round, or `UNREACHED`.
+   */
+  int getArrival(int round, StopId stop_id) const {
+    size_t i = find(round, stop_id);
+    return i == NOT_FOUND ? UNREACHED : arrivals_[i].seconds;
+  }
+
+  /**
+   * @brief Gets the label of a stop after a round.
+   *
+   * @param[in] round The round.
+   * @param[in] stop_id The index of the stop.
+   * @return The latest label of the stop written at or before the round, or an unset label if there is none.
+   */
+  StopInfo get(int round, StopId stop_id) const;
+
+  /**
+   * @brief Sets the label of a stop in a round.
+   *
+   * Labels of later rounds that are not earlier are replaced too, since a stop reached with fewer trips
+   * can be reached as early with more. They are left by the runs of previous departures of a profile query.
+   *
+   * @param[in] round The round.
+   * @param[in] stop_id The index of the stop.
+   * @param[in] stop_info The label, with an arrival time.
+   */
+  void set(int round, StopId stop_id, const StopInfo &stop_info);
+
+  /**
+   * @brief Gets the number of rounds with at least one label, in this query or a previous one.
+   *
+   * @return The number of rounds.
+   */
+  int numRounds() const;
+
+private:
+  static constexpr size_t NOT_FOUND = std::numeric_limits<size_t>::max(); ///< Index of unset labels.
+
+  /**
+   * @struct Arrival
+   * @brief The arrival time of a label, with the epoch it was written in.
+   */
+  struct Arrival {
+    uint32_t epoch; ///< Epoch in which the label was written.
+    int seconds; ///< Arrival time, in seconds.
+  };
+
+  /**
+   * @struct Parent
+   * @brief How the stop of a label was reached.
+   */
+  struct Parent {
+    TripId trip_id; ///< Index of the parent trip, or `NO_TRIP`.
+    StopId stop_id; ///< Index of the parent stop, or `NO_STOP`.
+    uint32_t boarding_position; ///< Position of the parent stop in the route of the parent trip.
+    int trip_day; ///< Service day of the parent trip, in days from the query date.
+  };
+
+  /**
+   * @struct StopRounds
+   * @brief The rounds in which a stop is labelled.
+   */
+  struct StopRounds {
+    uint32_t epoch; ///< Epoch in which the stop was last labelled.
+    int last_round; ///< Latest round in which the stop was labelled, in that epoch.
+  };
+
+  size_t num_stops_ = 0; ///< Number of stops of the timetable queried.
+  uint32_t epoch_ = 0; ///< Epoch of the current query.
+  std::vector<Arrival> arrivals_; ///< Arrival of each stop (inner) in each round (outer), flattened.
+  std::vector<Parent> parents_; ///< Parent of each stop (inner) in each round (outer), flattened.
+  std::vector<StopRounds> stop_rounds_; ///< Rounds in which each stop is labelled.
+
+  /**
+   * @brief Finds the latest label of a stop written at or before a round.
+   *
+   * @param[in] round The round.
+   * @param[in] stop_id The index of the stop.
+   * @return The index of the label in the flattened arrays, or `NOT_FOUND`.
+   */
+  size_t find(int round, StopId stop_id) const {
+    if (stop_rounds_[stop_id].epoch != epoch_) return NOT_FOUND;
+
+    for (int r = std::min(round, stop_rounds_[stop_id].last_round); r >= 0; --r) {
+      size_t i = static_cast<size_t>(r) * num_stops_ + stop_id;
+      if (arrivals_[i].epoch == epoch_) return i;
+    }
+    return NOT_FOUND;
+  }
+};
+
+#endif //RAPTOR_ROUNDLABELS_H
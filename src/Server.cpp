@@ -0,0 +1,186 @@
+/**
+ * @file Server.cpp
+ * @brief Server class implementation
+ *
+ * This file contains the implementation of the Server class, which reads newline-delimited
+ * JSON queries from local sockets and answers them on a pool of workers.
+ */
+
+#include "Server.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+/**
+ * @struct Server::Connection
+ * @brief A socket, closed once its owner is gone.
+ *
+ * Client sockets are shared by their reader and the workers answering their requests.
+ */
+struct Server::Connection {
+  int fd; ///< The socket.
+  std::mutex write_mutex; ///< Keeps the responses of concurrent workers from interleaving.
+
+  /**
+   * @brief Takes ownership of a socket.
+   * @param[in] fd The socket.
+   */
+  explicit Connection(int fd) : fd(fd) {}
+
+  /**
+   * @brief Closes the socket.
+   */
+  ~Connection() {
+    if (fd >= 0) close(fd);
+  }
+
+  /**
+   * @brief Writes a response, dropping it if the client is gone.
+   * @param[in] response The response, with its trailing newline.
+   */
+  void write(const std::string &response) {
+    std::lock_guard<std::mutex> lock(write_mutex);
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+      ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return;
+      sent += n;
+    }
+  }
+};
+
+Server::Server(const Raptor &raptor, size_t num_workers) : raptor_(raptor), pool_(num_workers) {}
+
+void Server::listen(const std::string &address) {
+  std::unique_ptr<Connection> listener; // Closes the socket, whatever fails
+
+  // Paths are Unix sockets, anything else a TCP port on the loopback interface
+  if (address.find('/') != std::string::npos) {
+    sockaddr_un socket_address{};
+    socket_address.sun_family = AF_UNIX;
+    if (address.size() >= sizeof(socket_address.sun_path))
+      throw std::runtime_error("Socket path too long: " + address);
+    std::strcpy(socket_address.sun_path, address.c_str());
+
+    listener = std::make_unique<Connection>(socket(AF_UNIX, SOCK_STREAM, 0));
+    unlink(address.c_str()); // Left over by a previous server
+    if (listener->fd < 0
+        || bind(listener->fd, reinterpret_cast<sockaddr *>(&socket_address), sizeof(socket_address)) != 0)
+      throw std::runtime_error("Could not bind to " + address + ": " + std::strerror(errno));
+
+  } else {
+    int port = Utils::parseInt(address);
+    if (port <= 0 || port > 65535) throw std::runtime_error("Invalid port: " + address);
+
+    sockaddr_in socket_address{};
+    socket_address.sin_family = AF_INET;
+    socket_address.sin_port = htons(port);
+    socket_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    listener = std::make_unique<Connection>(socket(AF_INET, SOCK_STREAM, 0));
+    int reuse = 1;
+    if (listener->fd < 0 || setsockopt(listener->fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0
+        || bind(listener->fd, reinterpret_cast<sockaddr *>(&socket_address), sizeof(socket_address)) != 0)
+      throw std::runtime_error("Could not bind to port " + address + ": " + std::strerror(errno));
+  }
+
+  if (::listen(listener->fd, SOMAXCONN) != 0)
+    throw std::runtime_error("Could not listen on " + address + ": " + std::strerror(errno));
+
+  std::cout << "Listening on " << address << " with " << pool_.size() << " worker(s)." << std::endl;
+
+  while (true) {
+    int client = accept(listener->fd, nullptr, nullptr);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      throw std::runtime_error(std::string("Could not accept connection: ") + std::strerror(errno));
+    }
+
+    // Each connection is read by its own thread, while the workers answer its requests
+    std::thread(&Server::serve, this, std::make_shared<Connection>(client)).detach();
+  }
+}
+
+void Server::serve(std::shared_ptr<Connection> connection) {
+  std::string buffer;
+  char chunk[4096];
+
+  while (true) {
+    ssize_t n = read(connection->fd, chunk, sizeof(chunk));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+
+    buffer.append(chunk, n);
+
+    size_t start = 0;
+    for (size_t end; (end = buffer.find('\n', start)) != std::string::npos; start = end + 1) {
+      if (end - start > MAX_REQUEST_LENGTH) return reject(*connection);
+
+      std::string request = buffer.substr(start, end - start);
+      if (!request.empty() && request.back() == '\r') request.pop_back();
+
+      if (request.find_first_not_of(" \t") != std::string::npos)
+        dispatch(connection, std::move(request), std::chrono::steady_clock::now());
+    }
+    buffer.erase(0, start);
+
+    // A client that never ends its line would otherwise fill the memory
+    if (buffer.size() > MAX_REQUEST_LENGTH) return reject(*connection);
+  }
+}
+
+void Server::reject(Connection &connection) {
+  connection.write("{\"id\":null,\"error\":\"Request longer than " + std::to_string(MAX_REQUEST_LENGTH)
+                   + " bytes.\"}\n");
+
+  // Closing with unread input resets the connection, which can discard the error, so some input is drained first
+  timeval timeout = {1, 0};
+  setsockopt(connection.fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  char chunk[4096];
+  for (size_t drained = 0; drained < MAX_REQUEST_LENGTH;) {
+    ssize_t n = read(connection.fd, chunk, sizeof(chunk));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    drained += n;
+  }
+}
+
+void Server::dispatch(const std::shared_ptr<Connection> &connection, std::string request,
+                      std::chrono::steady_clock::time_point received) {
+  if (pending_.fetch_add(1) >= MAX_PENDING_PER_WORKER * pool_.size()) {
+    pending_--;
+
+    std::string id = QueryRequest::fromJson(request).id;
+    connection->write("{\"id\":" + id + ",\"error\":\"Too many pending requests.\"}\n");
+    return;
+  }
+
+  pool_.submit([this, connection, request = std::move(request), received]() {
+    auto started = std::chrono::steady_clock::now();
+    std::string response = QueryRequest::fromJson(request).answer(raptor_);
+    auto finished = std::chrono::steady_clock::now();
+    pending_--;
+
+    auto microseconds = [](std::chrono::steady_clock::duration duration) {
+      return std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    };
+
+    QueryRequest::addField(response, "queue_us", microseconds(started - received));
+    QueryRequest::addField(response, "latency_us", microseconds(finished - received));
+    connection->write(response + "\n");
+  });
+}
+
+std::string Server::answer(std::string_view request, QueryContext &context) const {
+  return QueryRequest::fromJson(request).answer(raptor_, context);
+}
@@ -0,0 +1,102 @@
+/**
+ * @file Server.h
+ * @brief Defines the Server class, which answers RAPTOR queries received over a local socket.
+ *
+ * This header file declares the Server class. Clients send one JSON query per line, over a TCP
+ * connection to localhost or a Unix socket, and receive one JSON response per line. Queries are
+ * answered concurrently by a fixed pool of workers, each reusing its own QueryContext.
+ */
+
+#ifndef RAPTOR_SERVER_H
+#define RAPTOR_SERVER_H
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <atomic>
+#include <chrono>
+
+#include "Raptor.h"
+#include "QueryRequest.h"
+#include "ThreadPool.h"
+
+/**
+ * @class Server
+ * @brief Answers newline-delimited JSON queries with a pool of workers.
+ *
+ * A request is an object with the fields `source`, `target`, `date` (YYYYMMDD) and `time` (HH:MM:SS),
+ * an optional `latest_time` for profile queries, optional `criteria` for multi-criteria queries,
+ * and an optional `id` echoed in the response.
+ * Without a target, the earliest arrival at every reachable stop is returned instead of journeys.
+ * Every response reports how long the request waited for a worker (`queue_us`) and was in the server (`latency_us`).
+ *
+ * Requests received while too many are pending are rejected at once, so that latency stays bounded under load.
+ * A connection sending a line longer than MAX_REQUEST_LENGTH gets an error, and is closed.
+ * Responses on a connection may come out of order, and are matched to requests by their `id`.
+ */
+class Server {
+public:
+  static constexpr size_t MAX_PENDING_PER_WORKER = 16; ///< Pending requests per worker beyond which requests are rejected.
+  static constexpr size_t MAX_REQUEST_LENGTH = 64 * 1024; ///< Longest request line before the connection is closed.
+
+  /**
+   * @brief Starts the workers.
+   *
+   * @param[in] raptor The router answering the queries. Must outlive the server.
+   * @param[in] num_workers The number of workers. Defaults to the number of hardware threads.
+   */
+  explicit Server(const Raptor &raptor, size_t num_workers = std::max(1u, std::thread::hardware_concurrency()));
+
+  /**
+   * @brief Accepts connections and answers their requests, until the process is terminated.
+   *
+   * @param[in] address A port to listen on at 127.0.0.1, or the path of a Unix socket to create.
+   * @throws std::runtime_error If the socket cannot be created.
+   */
+  void listen(const std::string &address);
+
+  /**
+   * @brief Answers one request.
+   *
+   * @param[in] request The JSON request.
+   * @param[in,out] context The scratch state of the query.
+   * @return The JSON response, without latencies nor trailing newline. Invalid requests get an `error` field.
+   */
+  std::string answer(std::string_view request, QueryContext &context) const;
+
+private:
+  struct Connection;
+
+  const Raptor &raptor_; ///< Router answering the queries.
+  ThreadPool pool_; ///< Workers answering the queries.
+  std::atomic<size_t> pending_{0}; ///< Requests received but not answered yet.
+
+  /**
+   * @brief Reads the requests of a connection, and queues them on the workers until the client disconnects.
+   *
+   * @param[in] connection The connection.
+   */
+  void serve(std::shared_ptr<Connection> connection);
+
+  /**
+   * @brief Answers a request that is too long with an error.
+   *
+   * At most MAX_REQUEST_LENGTH more bytes are read, and discarded, for up to a second, so that the connection is
+   * not reset before the client reads the error. It is closed once the requests queued on it are answered.
+   *
+   * @param[in] connection The connection.
+   */
+  static void reject(Connection &connection);
+
+  /**
+   * @brief Queues a request on the workers, or rejects it if too many are pending.
+   *
+   * @param[in] connection The connection the request was received on.
+   * @param[in] request The JSON request.
+   * @param[in] received When the request was received.
+   */
+  void dispatch(const std::shared_ptr<Connection> &connection, std::string request,
+                std::chrono::steady_clock::time_point received);
+};
+
+#endif //RAPTOR_SERVER_H
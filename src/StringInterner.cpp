@@ -0,0 +1,62 @@
+/**
+ * @file StringInterner.cpp
+ * @brief StringInterner class implementation
+ *
+ * This file contains the implementation of the StringInterner class, which copies
+ * each distinct string once into an arena and hands out integer handles.
+ */
+
+#include "StringInterner.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+StringId StringInterner::intern(std::string_view str) {
+  if (std::optional<StringId> id = find(str)) return id.value();
+
+  std::unique_lock lock(mutex_);
+
+  // Another thread may have interned it since the lookup
+  auto it = ids_.find(str);
+  if (it != ids_.end()) return it->second;
+
+  if (blocks_.empty() || block_used_ + str.size() > BLOCK_SIZE) {
+    // Strings longer than a block get a block of their own
+    blocks_.push_back(std::make_unique<char[]>(std::max(BLOCK_SIZE, str.size())));
+    block_used_ = 0;
+  }
+
+  char *chars = blocks_.back().get() + block_used_;
+  if (!str.empty()) std::memcpy(chars, str.data(), str.size());
+  block_used_ = str.size() > BLOCK_SIZE ? BLOCK_SIZE : block_used_ + str.size();
+
+  auto id = static_cast<StringId>(strings_.size());
+  strings_.emplace_back(chars, str.size());
+  ids_.emplace(strings_.back(), id);
+
+  return id;
+}
+
+std::optional<StringId> StringInterner::find(std::string_view str) const {
+  std::shared_lock lock(mutex_);
+
+  auto it = ids_.find(str);
+  if (it == ids_.end()) return std::nullopt;
+  return it->second;
+}
+
+std::string_view StringInterner::get(StringId id) const {
+  std::shared_lock lock(mutex_);
+  return strings_[id];
+}
+
+std::vector<std::string_view> StringInterner::view() const {
+  std::shared_lock lock(mutex_);
+  return strings_;
+}
+
+size_t StringInterner::size() const {
+  std::shared_lock lock(mutex_);
+  return strings_.size();
+}
@@ -0,0 +1,83 @@
+/**
+ * @file StringInterner.h
+ * @brief Defines the StringInterner class, which stores each distinct string once.
+ *
+ * This header file declares the StringInterner class, used for the stop, trip, route, agency
+ * and service IDs of the parsed feeds, so that tables store and compare them as integer handles.
+ */
+
+#ifndef RAPTOR_STRINGINTERNER_H
+#define RAPTOR_STRINGINTERNER_H
+
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <cstdint>
+
+using StringId = uint32_t; ///< Handle of an interned string.
+
+/**
+ * @class StringInterner
+ * @brief Arena of distinct strings, identified by stable integer handles.
+ *
+ * Characters are copied into fixed-size blocks that are never moved, so the views returned
+ * by get() stay valid for the lifetime of the interner. Handles are assigned contiguously from 0.
+ * All methods are thread-safe.
+ */
+class StringInterner {
+public:
+  StringInterner() = default;
+
+  StringInterner(const StringInterner &) = delete;
+  StringInterner &operator=(const StringInterner &) = delete;
+
+  /**
+   * @brief Interns a string.
+   * @param[in] str The string.
+   * @return The handle of the string, the same for every call with equal strings.
+   */
+  StringId intern(std::string_view str);
+
+  /**
+   * @brief Looks up a string without interning it.
+   * @param[in] str The string.
+   * @return The handle of the string, or `std::nullopt` if it was never interned.
+   */
+  std::optional<StringId> find(std::string_view str) const;
+
+  /**
+   * @brief Gets an interned string.
+   * @param[in] id The handle of the string.
+   * @return A view over the string, valid for the lifetime of the interner.
+   */
+  std::string_view get(StringId id) const;
+
+  /**
+   * @brief Gets every interned string at once, so that many can be read without locking.
+   *
+   * Strings interned afterwards are not in the view, but the views stay valid for the lifetime of the interner.
+   *
+   * @return A view over each string, by handle.
+   */
+  std::vector<std::string_view> view() const;
+
+  /**
+   * @brief Gets the number of distinct strings.
+   * @return The number of strings interned, one more than the largest handle.
+   */
+  size_t size() const;
+
+private:
+  static constexpr size_t BLOCK_SIZE = 64 * 1024; ///< Size of an arena block in bytes.
+
+  mutable std::shared_mutex mutex_; ///< Guards every member below.
+  std::vector<std::unique_ptr<char[]>> blocks_; ///< Arena blocks holding the characters.
+  size_t block_used_ = 0; ///< Bytes used in the last block.
+  std::vector<std::string_view> strings_; ///< Interned string of each handle.
+  std::unordered_map<std::string_view, StringId> ids_; ///< Handle of each interned string.
+};
+
+#endif //RAPTOR_STRINGINTERNER_H
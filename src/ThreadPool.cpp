@@ -0,0 +1,73 @@
+/**
+ * @file ThreadPool.cpp
+ * @brief ThreadPool class implementation
+ *
+ * This file contains the implementation of the ThreadPool class, which runs
+ * queued tasks on a fixed set of worker threads.
+ */
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t num_threads) {
+  workers_.reserve(num_threads);
+
+  for (size_t i = 0; i < num_threads; ++i)
+    workers_.emplace_back([this]() {
+      while (true) {
+        std::function<void()> task;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+
+          if (tasks_.empty()) return; // Stopping, and nothing left to run
+
+          task = std::move(tasks_.front());
+          tasks_.pop_front();
+        }
+        task();
+      }
+    });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_all();
+
+  for (auto &worker: workers_)
+    worker.join();
+}
+
+size_t ThreadPool::size() const {
+  return workers_.size();
+}
+
+void ThreadPool::waitAll(std::vector<std::future<void>> &futures) {
+  std::exception_ptr exception;
+
+  for (auto &future: futures) {
+    try {
+      wait(future);
+    } catch (...) {
+      if (!exception) exception = std::current_exception();
+    }
+  }
+
+  if (exception) std::rethrow_exception(exception);
+}
+
+bool ThreadPool::runPendingTask() {
+  std::function<void()> task;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tasks_.empty()) return false;
+
+    task = std::move(tasks_.front());
+    tasks_.pop_front();
+  }
+  task();
+
+  return true;
+}
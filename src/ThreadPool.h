@@ -0,0 +1,129 @@
+/**
+ * @file ThreadPool.h
+ * @brief Defines the ThreadPool class, a fixed set of worker threads running queued tasks.
+ *
+ * This header file declares the ThreadPool class, used to parse GTFS files and feeds concurrently.
+ * Tasks may submit and wait for other tasks: a waiting thread runs queued tasks instead of blocking,
+ * so nested parallelism cannot exhaust the workers.
+ */
+
+#ifndef RAPTOR_THREADPOOL_H
+#define RAPTOR_THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <memory>
+#include <algorithm>
+
+/**
+ * @class ThreadPool
+ * @brief Runs tasks on a fixed number of worker threads.
+ */
+class ThreadPool {
+public:
+  /**
+   * @brief Starts the worker threads.
+   * @param[in] num_threads The number of workers. Defaults to the number of hardware threads.
+   */
+  explicit ThreadPool(size_t num_threads = std::max(1u, std::thread::hardware_concurrency()));
+
+  /**
+   * @brief Runs the remaining tasks, then joins the worker threads.
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * @brief Gets the number of worker threads.
+   * @return The number of workers.
+   */
+  size_t size() const;
+
+  /**
+   * @brief Queues a task.
+   * @param[in] task The callable to run.
+   * @return A future holding the task's result, or the exception it threw.
+   */
+  template<typename F>
+  std::future<std::invoke_result_t<F>> submit(F &&task) {
+    using Result = std::invoke_result_t<F>;
+
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+    std::future<Result> future = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace_back([packaged]() { (*packaged)(); });
+    }
+    condition_.notify_one();
+
+    return future;
+  }
+
+  /**
+   * @brief Waits for a task's result, running queued tasks in the meantime.
+   * @param[in] future The future returned by submit().
+   * @return The task's result.
+   * @throws Any exception thrown by the task.
+   */
+  template<typename T>
+  T wait(std::future<T> &future) {
+    while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      if (!runPendingTask())
+        future.wait_for(std::chrono::milliseconds(1));
+
+    return future.get();
+  }
+
+  /**
+   * @brief Calls a function on each index of a range, split into one block per worker, and waits.
+   * @param[in] count The number of indices, from 0 to count - 1.
+   * @param[in] function The function to call with each index.
+   * @throws The first exception thrown by the function, after every block has finished.
+   */
+  template<typename F>
+  void parallelFor(size_t count, F &&function) {
+    size_t num_blocks = std::min(count, size());
+    std::vector<std::future<void>> blocks;
+    blocks.reserve(num_blocks);
+
+    for (size_t block = 0; block < num_blocks; ++block)
+      blocks.push_back(submit([&function, block, num_blocks, count]() {
+        for (size_t i = block * count / num_blocks; i < (block + 1) * count / num_blocks; ++i)
+          function(i);
+      }));
+
+    waitAll(blocks);
+  }
+
+  /**
+   * @brief Waits for every task of a group, running queued tasks in the meantime.
+   *
+   * Every task is waited for even if one fails, so that none outlives the data it references.
+   *
+   * @param[in] futures The futures returned by submit().
+   * @throws The first exception thrown by the tasks, in submission order.
+   */
+  void waitAll(std::vector<std::future<void>> &futures);
+
+private:
+  std::vector<std::thread> workers_; ///< Worker threads.
+  std::deque<std::function<void()>> tasks_; ///< Queued tasks, run in order.
+  std::mutex mutex_; ///< Guards tasks_ and stopping_.
+  std::condition_variable condition_; ///< Signals queued tasks and stopping.
+  bool stopping_ = false; ///< Set when the pool is destroyed.
+
+  /**
+   * @brief Runs one queued task on the calling thread, if there is any.
+   * @return True if a task was run, false if the queue was empty.
+   */
+  bool runPendingTask();
+};
+
+#endif //RAPTOR_THREADPOOL_H
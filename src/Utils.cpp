@@ -11,6 +11,19 @@
 
 #include "Utils.h"
 
+#include <charconv> // for from_chars
+
+/**
+ * @brief Removes the spaces around a field.
+ * @param[in] str The field.
+ * @return A view over the field without leading and trailing spaces.
+ */
+static std::string_view trimSpaces(std::string_view str) {
+  while (!str.empty() && str.front() == ' ') str.remove_prefix(1);
+  while (!str.empty() && str.back() == ' ') str.remove_suffix(1);
+  return str;
+}
+
 double Utils::manhattan(const double &lat1, const double &lon1, const double &lat2, const double &lon2) {
   return std::abs(lat1 - lat2) + std::abs(lon1 - lon2);
 }
@@ -31,10 +44,16 @@ int Utils::getDuration(const std::string &string_lat1, const std::string &string
     throw std::runtime_error("Invalid latitude or longitude format.");
   }
 
-  double average_speed = 5.0; // km/h
-  double scaling_factor = 111.0; // Approximately 111 km per degree
-  double distance = Utils::manhattan(lat1, lon1, lat2, lon2) * scaling_factor;
-  return static_cast<int>(std::round((distance / average_speed) * 60 * 60)); // Seconds
+  return getDuration(lat1, lon1, lat2, lon2);
+}
+
+int Utils::getDuration(double lat1, double lon1, double lat2, double lon2) {
+  double distance = Utils::manhattan(lat1, lon1, lat2, lon2) * KM_PER_DEGREE;
+  return static_cast<int>(std::round((distance / WALKING_SPEED) * 60 * 60)); // Seconds
+}
+
+double Utils::getWalkingRadius(int duration) {
+  return (duration / (60.0 * 60.0)) * WALKING_SPEED / KM_PER_DEGREE; // Degrees
 }
 
 std::string Utils::secondsToTime(std::optional<int> seconds) {
@@ -55,15 +74,61 @@ std::string Utils::secondsToTime(std::optional<int> seconds) {
 }
 
 int Utils::timeToSeconds(const std::string &timeStr) {
-  int hours, minutes, seconds;
-  char colon;
+  return parseTime(timeStr);
+}
 
-  std::istringstream iss(timeStr);
-  iss >> hours >> colon >> minutes >> colon >> seconds;
+int Utils::parseTime(std::string_view str) {
+  str = trimSpaces(str);
+
+  // Hours have one or more digits, minutes and seconds exactly two
+  size_t colon = str.find(':');
+  if (colon == 0 || colon == std::string_view::npos || str.size() != colon + 6 || str[colon + 3] != ':')
+    throw std::runtime_error("Invalid time: " + std::string(str));
+
+  int hours = 0;
+  for (size_t i = 0; i < colon; ++i) {
+    if (str[i] < '0' || str[i] > '9') throw std::runtime_error("Invalid time: " + std::string(str));
+    hours = hours * 10 + (str[i] - '0');
+  }
+
+  for (size_t i: {colon + 1, colon + 2, colon + 4, colon + 5})
+    if (str[i] < '0' || str[i] > '9') throw std::runtime_error("Invalid time: " + std::string(str));
+
+  int minutes = (str[colon + 1] - '0') * 10 + (str[colon + 2] - '0');
+  int seconds = (str[colon + 4] - '0') * 10 + (str[colon + 5] - '0');
 
   return hours * 3600 + minutes * 60 + seconds;
 }
 
+int Utils::parseDate(std::string_view str) {
+  if (str.size() != 8 || !std::ranges::all_of(str, [](char c) { return c >= '0' && c <= '9'; }))
+    throw std::runtime_error("Invalid date: " + std::string(str));
+
+  return parseInt(str);
+}
+
+int Utils::parseInt(std::string_view str) {
+  str = trimSpaces(str);
+  int value = 0;
+  auto [end, error] = std::from_chars(str.data(), str.data() + str.size(), value);
+
+  if (error != std::errc() || end != str.data() + str.size() || str.empty())
+    throw std::runtime_error("Invalid integer: " + std::string(str));
+
+  return value;
+}
+
+double Utils::parseDouble(std::string_view str) {
+  str = trimSpaces(str);
+  double value = 0;
+  auto [end, error] = std::from_chars(str.data(), str.data() + str.size(), value);
+
+  if (error != std::errc() || end != str.data() + str.size() || str.empty())
+    throw std::runtime_error("Invalid number: " + std::string(str));
+
+  return value;
+}
+
 int Utils::timeToSeconds(const Time &time) {
   return time.hours * 3600 + time.minutes * 60 + time.seconds;
 }
@@ -108,40 +173,67 @@ int Utils::daysInMonth(int year, int month) {
   return daysInMonths[month - 1];
 }
 
-bool Utils::dateWithinRange(const Date &date, const std::string &start_date, const std::string &end_date) {
-  // Convert strings YYYYMMDD to Date objects
-  Date start = {std::stoi(start_date.substr(0, 4)), std::stoi(start_date.substr(4, 2)),
-                std::stoi(start_date.substr(6, 2))};
-  Date end = {std::stoi(end_date.substr(0, 4)), std::stoi(end_date.substr(4, 2)), std::stoi(end_date.substr(6, 2))};
-
-  // Check if the date is earlier than the start date
-  if ((date.year < start.year)
-      || (date.year == start.year && date.month < start.month)
-      || (date.year == start.year && date.month == start.month && date.day < start.day))
-    return false;
+int Utils::getWeekday(int year, int month, int day) {
+  // Sakamoto's method, counting January and February as months of the previous year
+  static const int offsets[] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+  if (month < 3) year--;
+  return (year + year / 4 - year / 100 + year / 400 + offsets[month - 1] + day) % 7;
+}
 
-  // Check if the date is later than the end date
-  if ((date.year > end.year)
-      || (date.year == end.year && date.month > end.month)
-      || (date.year == end.year && date.month == end.month && date.day > end.day))
-    return false;
+int Utils::daysSinceEpoch(int year, int month, int day) {
+  // Count years from March, so that the leap day ends the year
+  if (month < 3) year--;
+  int era = (year >= 0 ? year : year - 399) / 400;
+  int year_of_era = year - era * 400;
+  int day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+  return era * 146097 + day_of_era - 719468;
+}
 
-  return true;
+Date Utils::dateFromDays(int days) {
+  days += 719468;
+  int era = (days >= 0 ? days : days - 146096) / 146097;
+  int day_of_era = days - era * 146097;
+  int year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+  int day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  int month_from_march = (5 * day_of_year + 2) / 153;
+  int day = day_of_year - (153 * month_from_march + 2) / 5 + 1;
+  int month = month_from_march < 10 ? month_from_march + 3 : month_from_march - 9;
+  int year = year_of_era + era * 400 + (month <= 2);
+
+  // 1970-01-01 was a Thursday
+  int weekday = ((days - 719468) % 7 + 11) % 7;
+  return {year, month, day, weekday};
 }
 
 Date Utils::addOneDay(Date date) {
-  std::tm time_info = {};
-  time_info.tm_year = date.year - 1900;
-  time_info.tm_mon = date.month - 1;
-  time_info.tm_mday = date.day + 1; // Add one day
-
-  std::mktime(&time_info); // Normalize the date
-  Date new_date = {time_info.tm_year + 1900, time_info.tm_mon + 1, time_info.tm_mday};
-
-  return new_date;
+  return dateFromDays(daysSinceEpoch(date.year, date.month, date.day) + 1);
 }
 
 std::string Utils::dayToString(Day day) {
-  return (day == Day::CurrentDay) ? "current" : "next";
+  if (day == Day::CurrentDay) return "current";
+  if (day == Day::NextDay) return "next";
+  return "+" + std::to_string(static_cast<int>(day));
 }
 
+
+std::vector<Criterion> Utils::parseCriteria(std::string_view str) {
+  std::vector<Criterion> criteria;
+  if (str.empty()) return criteria;
+
+  size_t start = 0;
+  while (true) {
+    size_t end = str.find(',', start);
+    std::string_view name = str.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+
+    if (name == "walking") criteria.push_back(Criterion::WalkingTime);
+    else if (name == "agencies") criteria.push_back(Criterion::AgencyChanges);
+    else if (name == "zones") criteria.push_back(Criterion::FareZones);
+    else throw std::runtime_error("Unknown criterion " + std::string(name) + ".");
+
+    if (end == std::string_view::npos) break;
+    start = end + 1;
+  }
+
+  return criteria;
+}
@@ -18,8 +18,10 @@
 #include <utility> // for std::pair
 #include <vector>
 #include <cmath>
+#include <string_view>
 
 #include "DateTime.h"
+#include "NetworkObjects/DataStructures.h"
 
 /**
  * @class Utils
@@ -32,6 +34,9 @@
 class Utils {
 public:
 
+  static constexpr double WALKING_SPEED = 5.0;   ///< Average walking speed in km/h.
+  static constexpr double KM_PER_DEGREE = 111.0; ///< Approximate length of a degree in km.
+
   /**
    * @brief Computes the Manhattan distance between two geographical points.
    *
@@ -62,6 +67,29 @@ public:
   static int getDuration(const std::string &string_lat1, const std::string &string_lon1,
                          const std::string &string_lat2, const std::string &string_lon2);
 
+  /**
+   * @brief Calculates the duration between two geographical points in seconds.
+   *
+   * The duration is the Manhattan distance, converted to kilometers, walked at WALKING_SPEED.
+   *
+   * @param[in] lat1 Latitude of the first point.
+   * @param[in] lon1 Longitude of the first point.
+   * @param[in] lat2 Latitude of the second point.
+   * @param[in] lon2 Longitude of the second point.
+   * @return The duration in seconds.
+   */
+  static int getDuration(double lat1, double lon1, double lat2, double lon2);
+
+  /**
+   * @brief Calculates the Manhattan distance that can be walked in a given duration.
+   *
+   * This is the inverse of getDuration, used to bound spatial searches.
+   *
+   * @param[in] duration The walking duration in seconds.
+   * @return The distance in decimal degrees.
+   */
+  static double getWalkingRadius(int duration);
+
   /**
    * @brief Converts a time in seconds to a string format (HH:MM:SS).
    *
@@ -83,6 +111,42 @@ public:
    */
   static int timeToSeconds(const std::string &timeStr);
 
+  /**
+   * @brief Parses a GTFS time (H:MM:SS, hours possibly beyond 24) to the equivalent number of seconds.
+   *
+   * @param[in] str The time, possibly surrounded by spaces.
+   * @return The total time in seconds.
+   * @throws std::runtime_error If the time is malformed.
+   */
+  static int parseTime(std::string_view str);
+
+  /**
+   * @brief Parses a GTFS date (YYYYMMDD).
+   *
+   * @param[in] str The date.
+   * @return The date as the integer YYYYMMDD.
+   * @throws std::runtime_error If the date is not 8 digits.
+   */
+  static int parseDate(std::string_view str);
+
+  /**
+   * @brief Parses a decimal integer.
+   *
+   * @param[in] str The integer, optionally signed.
+   * @return The parsed integer.
+   * @throws std::runtime_error If the string is not an integer.
+   */
+  static int parseInt(std::string_view str);
+
+  /**
+   * @brief Parses a decimal floating-point number.
+   *
+   * @param[in] str The number.
+   * @return The parsed number.
+   * @throws std::runtime_error If the string is not a number.
+   */
+  static double parseDouble(std::string_view str);
+
   /**
    * @brief Converts a Time object to the equivalent number of seconds.
    *
@@ -145,16 +209,32 @@ public:
   static int daysInMonth(int year, int month);
 
   /**
-   * @brief Checks if a date is within a specified date range.
+   * @brief Computes the day of the week of a date.
    *
-   * This method checks whether a given date falls within the specified range of start and end dates.
+   * @param[in] year The year of the date.
+   * @param[in] month The month of the date (1-12).
+   * @param[in] day The day of the month.
+   * @return The day of the week (0 = Sunday, 1 = Monday, ..., 6 = Saturday).
+   */
+  static int getWeekday(int year, int month, int day);
+
+  /**
+   * @brief Counts the days from 1970-01-01 to a date.
    *
-   * @param[in] date The date to be checked.
-   * @param[in] start_date The start of the date range (in string format).
-   * @param[in] end_date The end of the date range (in string format).
-   * @return True if the date is within the range, false otherwise.
+   * @param[in] year The year of the date.
+   * @param[in] month The month of the date (1-12).
+   * @param[in] day The day of the month.
+   * @return The number of days, negative for earlier dates.
    */
-  static bool dateWithinRange(const Date &date, const std::string &start_date, const std::string &end_date);
+  static int daysSinceEpoch(int year, int month, int day);
+
+  /**
+   * @brief Gets the date a number of days after 1970-01-01.
+   *
+   * @param[in] days The number of days, negative for earlier dates.
+   * @return The date, with its day of the week.
+   */
+  static Date dateFromDays(int days);
 
   /**
    * @brief Adds one day to a given date.
@@ -162,19 +242,29 @@ public:
    * This method increments the given date by one day.
    *
    * @param[in] date The date to which one day should be added.
-   * @return The resulting date after adding one day.
+   * @return The resulting date after adding one day, with its day of the week.
    */
   static Date addOneDay(Date date);
 
   /**
    * @brief Converts a Day enum to a string representation.
    *
-   * This method converts a Day enum (Current or Next) to its string representation.
+   * This method converts a Day enum (Current or Next) to its string representation,
+   * or later days to their number of days after the current day (e.g. "+2").
    *
    * @param[in] day The Day enum to be converted.
    * @return The string representation of the specified day.
    */
   static std::string dayToString(Day day);
+
+  /**
+   * @brief Parses the criteria of a multi-criteria query.
+   *
+   * @param[in] str The names of the criteria, separated by commas: `walking`, `agencies` or `zones`.
+   * @return The criteria, in the order given.
+   * @throws std::runtime_error If a name is unknown.
+   */
+  static std::vector<Criterion> parseCriteria(std::string_view str);
 };
 
 #endif //RAPTOR_UTILS_H
@@ -7,6 +7,7 @@
  */
 
 #include <iostream>
+#include <cstring>
 #include "Application.h"
 
 /**
@@ -14,6 +15,13 @@
  *
  * This function parses command-line arguments or prompts the user for GTFS input directories,
  * initializes the application, and starts the interactive event loop.
+ * With `--compile <dirs...> -o <file>`, it writes a binary timetable snapshot instead,
+ * which can then be passed as the only argument to skip parsing. `--verify <network.bin>` checks the checksum
+ * of a snapshot, which loading skips.
+ * `--max-walk <seconds>` sets the longest footpath generated between stops.
+ * With `--serve <port|socket path>`, it answers JSON queries over a local socket instead of the terminal,
+ * on `--workers <n>` threads. With `--batch <queries.csv> --out <results.jsonl>`, it answers a file of queries
+ * on as many threads, and writes one JSON response per line.
  *
  * @param argc Number of command-line arguments.
  * @param argv Array of command-line arguments.
@@ -21,11 +29,55 @@
  */
 int main(int argc, char *argv[]) {
   std::vector<std::string> inputDirectories;
+  bool compile = false;
+  bool verify = false;
+  std::string output;
+  std::string address;
+  std::string queries;
+  size_t numWorkers = 0;
+  int maxWalkingDuration = DEFAULT_MAX_WALKING_DURATION;
 
-  // Parse command-line arguments for input directories
+  // Parse command-line arguments for input directories, or a snapshot file
+  // Usage: raptor [--compile | --verify] [--max-walk seconds] [--serve address] [--batch queries.csv] [--workers n]
+  //               <dirs...> [-o network.bin | --out results.jsonl]
   if (argc >= 2) {
-    for (int i = 1; i < argc; ++i)
-      inputDirectories.emplace_back(argv[i]);
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+
+      if (arg == "--compile") compile = true;
+      else if (arg == "--verify") verify = true;
+      else if ((arg == "-o" || arg == "--out") && i + 1 < argc) output = argv[++i];
+      else if (arg == "--serve" && i + 1 < argc) address = argv[++i];
+      else if (arg == "--batch" && i + 1 < argc) queries = argv[++i];
+      else if (arg == "--max-walk" || arg == "--workers") {
+        // A missing or malformed number would otherwise be taken for a directory
+        int value = -1;
+        if (i + 1 < argc && Utils::isNumber(argv[i + 1]) && std::strlen(argv[i + 1]) <= 9) value = std::stoi(argv[++i]);
+        if (value < 0) {
+          std::cerr << "Usage: " << argv[0] << " " << arg << " <" << (arg == "--max-walk" ? "seconds" : "n") << "> ..."
+                    << std::endl;
+          return 1;
+        }
+
+        if (arg == "--max-walk") maxWalkingDuration = value;
+        else numWorkers = value;
+      } else inputDirectories.push_back(arg);
+    }
+
+    if (compile && (output.empty() || inputDirectories.empty())) {
+      std::cerr << "Usage: " << argv[0] << " --compile <dirs...> -o <network.bin>" << std::endl;
+      return 1;
+    }
+
+    if (verify && inputDirectories.size() != 1) {
+      std::cerr << "Usage: " << argv[0] << " --verify <network.bin>" << std::endl;
+      return 1;
+    }
+
+    if (!queries.empty() && (output.empty() || inputDirectories.empty())) {
+      std::cerr << "Usage: " << argv[0] << " --batch <queries.csv> --out <results.jsonl> <dirs...>" << std::endl;
+      return 1;
+    }
 
   } else {
     // Prompt user for input directories
@@ -40,8 +92,18 @@ int main(int argc, char *argv[]) {
   }
 
   // Initialize and run the application
-  Application application(inputDirectories);
-  application.run();
+  Application application(inputDirectories, maxWalkingDuration);
+
+  try {
+    if (compile) application.compile(output);
+    else if (verify) application.verify();
+    else if (!address.empty()) application.serve(address, numWorkers);
+    else if (!queries.empty()) application.batch(queries, output, numWorkers);
+    else application.run();
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
 
   return 0;
 }
@@ -11,48 +11,28 @@
 
 #include "gtest/gtest.h"
 #include "./src/Raptor.h"
+#include "./src/Server.h"
+#include "./src/BatchRunner.h"
+#include "./src/ParetoSet.h"
+
+#include <map>
+#include <thread>
+#include <fstream>
+#include <filesystem>
 
 /**
  * @brief Loads data from GTFS files into in-memory data structures.
  *
  * @param inputDirectories A vector of strings containing paths to GTFS directories.
- * @param agencies A map to store agency data.
- * @param calendars A map to store calendar data.
- * @param trips A map to store trip data.
- * @param routes A map to store route data.
- * @param stops A map to store stop data.
- * @param stop_times A map to store stop time data.
- */
-void loadData(
-        const std::vector<std::string> &inputDirectories,
-        std::unordered_map<std::string, Agency> &agencies,
-        std::unordered_map<std::string, Calendar> &calendars,
-        std::unordered_map<std::string, Trip> &trips,
-        std::unordered_map<std::pair<std::string, std::string>, Route, pair_hash> &routes,
-        std::unordered_map<std::string, Stop> &stops,
-        std::unordered_map<std::pair<std::string, std::string>, StopTime, pair_hash> &stop_times) {
+ * @param feed The feed to merge the parsed tables into.
+ */
+void loadData(const std::vector<std::string> &inputDirectories, GTFSFeed &feed) {
 
   for (const auto &dir: inputDirectories) {
 
     Parser parser(dir);
 
-    auto dirAgencies = parser.getAgencies();
-    agencies.insert(dirAgencies.begin(), dirAgencies.end());
-
-    auto dirCalendars = parser.getCalendars();
-    calendars.insert(dirCalendars.begin(), dirCalendars.end());
-
-    auto dirTrips = parser.getTrips();
-    trips.insert(dirTrips.begin(), dirTrips.end());
-
-    auto dirRoutes = parser.getRoutes();
-    routes.insert(dirRoutes.begin(), dirRoutes.end());
-
-    auto dirStops = parser.getStops();
-    stops.insert(dirStops.begin(), dirStops.end());
-
-    auto dirStopTimes = parser.getStopTimes();
-    stop_times.insert(dirStopTimes.begin(), dirStopTimes.end());
+    feed.merge(parser.getFeed());
   }
 }
 
@@ -76,16 +56,11 @@ protected:
     std::vector<std::string> inputDirectories = {std::string(DATASET_PATH) + "/Porto/stcp/GTFS/",
                                                  std::string(DATASET_PATH) + "/Porto/metro/GTFS/"};
 
-    std::unordered_map<std::string, Agency> agencies;
-    std::unordered_map<std::string, Calendar> calendars;
-    std::unordered_map<std::string, Trip> trips;
-    std::unordered_map<std::pair<std::string, std::string>, Route, pair_hash> routes;
-    std::unordered_map<std::string, Stop> stops;
-    std::unordered_map<std::pair<std::string, std::string>, StopTime, pair_hash> stop_times;
+    GTFSFeed feed;
 
-    loadData(inputDirectories, agencies, calendars, trips, routes, stops, stop_times);
+    loadData(inputDirectories, feed);
 
-    raptor = Raptor(agencies, calendars, stops, routes, trips, stop_times);
+    raptor = Raptor(feed);
   }
 
 };
@@ -317,3 +292,463 @@ TEST_F(RaptorTests, from5717_toPREC2) {
   for (auto &journey: journeys)
     ASSERT_TRUE(raptor.isValidJourney(journey));
 }
+
+/**
+ * @test ProfileQuery
+ * @brief Tests a profile query over a departure window, whose journeys must all depart within the window.
+ */
+TEST_F(RaptorTests, ProfileQuery) {
+  Query query = {"5777", "5776", {2024, 10, 15}, {7, 0, 0}, Time{8, 0, 0}};
+  raptor.setQuery(query);
+
+  auto journeys = raptor.findProfileJourneys();
+
+  ASSERT_FALSE(journeys.empty());
+  for (size_t i = 0; i < journeys.size(); ++i) {
+    ASSERT_TRUE(raptor.isValidJourney(journeys[i]));
+    ASSERT_GE(journeys[i].departure_secs, 7 * 3600);
+    ASSERT_LE(journeys[i].departure_secs, 8 * 3600);
+    if (i > 0) {
+      ASSERT_GT(journeys[i].departure_secs, journeys[i - 1].departure_secs);  // Later departures only
+      ASSERT_GT(journeys[i].arrival_secs, journeys[i - 1].arrival_secs);      // arrive later
+    }
+  }
+}
+
+/**
+ * @test OneToAllQuery
+ * @brief Tests that a one-to-all query reaches the target of a single query no later than it does.
+ */
+TEST_F(RaptorTests, OneToAllQuery) {
+  Query query = {"5777", "5776", {2024, 10, 15}, {8, 0, 0}};
+  raptor.setQuery(query);
+
+  auto journeys = raptor.findJourneys();
+  ASSERT_FALSE(journeys.empty());
+
+  raptor.setQuery({"5777", "", {2024, 10, 15}, {8, 0, 0}});
+  RoundArrivals arrivals = raptor.findAllArrivals();
+
+  StopId target = raptor.getTimetable().findStop("5776").value();
+  ASSERT_TRUE(arrivals.back()[target].has_value());
+  for (const Journey &journey: journeys)
+    ASSERT_LE(arrivals.back()[target].value(), journey.arrival_secs);
+}
+
+/**
+ * @test ConcurrentQueries
+ * @brief Tests that queries answered concurrently, each with its own context, match the same queries answered in turn.
+ */
+TEST_F(RaptorTests, ConcurrentQueries) {
+  std::vector<Query> queries = {{"5777", "5776", {2024, 10, 15}, {22, 30, 0}},
+                                {"5726", "5739", {2024, 10, 15}, {6, 44, 0}},
+                                {"5753", "5782", {2024, 10, 15}, {19, 44, 0}},
+                                {"5733", "5708", {2024, 10, 19}, {13, 7, 0}}};
+
+  std::vector<std::vector<Journey>> expected;
+  for (const Query &query: queries) {
+    raptor.setQuery(query);
+    expected.push_back(raptor.findJourneys());
+  }
+
+  std::vector<std::vector<Journey>> journeys(queries.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < queries.size(); ++i)
+    threads.emplace_back([&, i]() {
+      QueryContext context;
+      context.query = queries[i];
+      journeys[i] = raptor.findJourneys(context);
+    });
+  for (std::thread &thread: threads)
+    thread.join();
+
+  for (size_t i = 0; i < queries.size(); ++i) {
+    ASSERT_EQ(journeys[i].size(), expected[i].size());
+    for (size_t j = 0; j < journeys[i].size(); ++j) {
+      ASSERT_EQ(journeys[i][j].departure_secs, expected[i][j].departure_secs);
+      ASSERT_EQ(journeys[i][j].arrival_secs, expected[i][j].arrival_secs);
+      ASSERT_EQ(journeys[i][j].steps.size(), expected[i][j].steps.size());
+    }
+  }
+}
+
+/**
+ * @test ServerAnswer
+ * @brief Tests the JSON responses of the query server, for a valid and an invalid request.
+ */
+TEST_F(RaptorTests, ServerAnswer) {
+  Server server(raptor, 1);
+  QueryContext context;
+  context.verbose = false;
+
+  std::string response = server.answer(
+          R"({"id": 7, "source": "5777", "target": "5776", "date": "20241015", "time": "22:30:00"})", context);
+  ASSERT_EQ(response.rfind("{\"id\":7,\"journeys\":[{", 0), 0);
+
+  response = server.answer(R"({"id": "x", "source": "5777", "date": "2024-10-15", "time": "22:30:00"})", context);
+  ASSERT_EQ(response.rfind("{\"id\":\"x\",\"error\":", 0), 0);
+}
+
+/**
+ * @test MalformedRequests
+ * @brief Tests that only JSON literals are echoed as IDs, and that malformed requests are reported.
+ */
+TEST(QueryRequestTests, MalformedRequests) {
+  ASSERT_EQ(QueryRequest::fromJson(R"({"id": -1.5e3})").id, "-1.5e3");
+  ASSERT_EQ(QueryRequest::fromJson(R"({"id": true})").id, "true");
+  ASSERT_EQ(QueryRequest::fromJson(R"({"source": "AB"})").source, "AB");
+
+  for (const char *json: {R"({"id": abc})", R"({"id": 1]})", R"({"id": 01})", R"({"source": "\u12zz"})"}) {
+    QueryRequest request = QueryRequest::fromJson(json);
+    ASSERT_FALSE(request.error.empty()) << json;
+    ASSERT_EQ(request.id, "null") << json;
+  }
+}
+
+/**
+ * @test BatchQueries
+ * @brief Tests that a file of queries is answered one line per row, in input order.
+ */
+TEST_F(RaptorTests, BatchQueries) {
+  std::string queries_path = testing::TempDir() + "queries.csv";
+  std::string output_path = testing::TempDir() + "results.jsonl";
+
+  std::ofstream(queries_path) << "source,target,date,time\n"
+                                 "5777,5776,20241015,22:30:00\n"
+                                 "5777,5776,2024-10-15,22:30:00\n"
+                                 "5777,,20241015,22:30:00\n";
+
+  BatchRunner(raptor, 2).run(queries_path, output_path);
+
+  std::ifstream output(output_path);
+  std::vector<std::string> responses;
+  for (std::string line; std::getline(output, line);) responses.push_back(line);
+
+  ASSERT_EQ(responses.size(), 3);
+  ASSERT_EQ(responses[0].rfind("{\"id\":1,\"journeys\":[{", 0), 0);
+  ASSERT_EQ(responses[1].rfind("{\"id\":2,\"error\":", 0), 0);
+  ASSERT_EQ(responses[2].rfind("{\"id\":3,\"arrivals\":{", 0), 0);
+}
+
+/**
+ * @brief Writes a minimal GTFS feed to a directory of the temporary directory.
+ *
+ * Unless given, the feed has a single agency `A` and a service `S` running every day of 2024.
+ *
+ * @param name The name of the directory.
+ * @param files The rows of each file, without their header.
+ * @return The path of the directory.
+ */
+static std::string writeFeed(const std::string &name, std::map<std::string, std::string> files) {
+  static const std::map<std::string, std::string> headers = {
+          {"agency.txt", "agency_id,agency_name"},
+          {"calendar.txt", "service_id,monday,tuesday,wednesday,thursday,friday,saturday,sunday,start_date,end_date"},
+          {"calendar_dates.txt", "service_id,date,exception_type"},
+          {"routes.txt", "route_id,agency_id"},
+          {"trips.txt", "route_id,service_id,trip_id"},
+          {"stops.txt", "stop_id,stop_name,stop_lat,stop_lon,zone_id"},
+          {"stop_times.txt", "trip_id,arrival_time,departure_time,stop_id,stop_sequence"},
+          {"transfers.txt", "from_stop_id,to_stop_id,transfer_type,min_transfer_time"}};
+
+  files.try_emplace("agency.txt", "A,Line\n");
+  files.try_emplace("calendar.txt", "S,1,1,1,1,1,1,1,20240101,20241231\n");
+
+  std::string dir = testing::TempDir() + name + "/";
+  std::filesystem::create_directories(dir);
+  for (const auto &[file, rows]: files) std::ofstream(dir + file) << headers.at(file) << "\n" << rows;
+
+  return dir;
+}
+
+/**
+ * @test LoopRoute
+ * @brief Tests that a route visiting a stop twice is boarded at the visit the journey departs from.
+ */
+TEST(LoopRouteTests, BoardsAtLaterVisit) {
+  Parser parser(writeFeed("loop", {
+          {"routes.txt", "R,A\n"},
+          {"trips.txt", "R,S,T\n"},
+          {"stops.txt", "L1,One,41.0,-8.6,\nL2,Two,41.1,-8.6,\nL3,Three,41.2,-8.6,\nL4,Four,41.3,-8.6,\n"},
+          {"stop_times.txt", "T,08:00:00,08:00:00,L1,1\nT,08:10:00,08:10:00,L2,2\nT,08:20:00,08:20:00,L3,3\n"
+                             "T,08:30:00,08:30:00,L1,4\nT,08:40:00,08:40:00,L4,5\n"}}));
+  Raptor loop_raptor(parser.getFeed(), DEFAULT_MAX_WALKING_DURATION);
+
+  loop_raptor.setQuery({"L1", "L4", {2024, 10, 15, 2}, {8, 15, 0}});
+  std::vector<Journey> journeys = loop_raptor.findJourneys();
+
+  ASSERT_EQ(journeys.size(), 1);
+  ASSERT_EQ(journeys[0].steps.size(), 1);
+  ASSERT_EQ(journeys[0].steps[0].departure_secs, Utils::timeToSeconds("08:30:00"));
+  ASSERT_EQ(journeys[0].steps[0].arrival_secs, Utils::timeToSeconds("08:40:00"));
+}
+
+/**
+ * @test UnknownStops
+ * @brief Tests that queries reject unknown stops with the same error, but one-to-all queries ignore the target.
+ */
+TEST(UnknownStopTests, ThrowsRuntimeError) {
+  Parser parser(writeFeed("unknown_stops", {
+          {"routes.txt", "R,A\n"},
+          {"trips.txt", "R,S,T\n"},
+          {"stops.txt", "L1,One,41.0,-8.6,\nL2,Two,41.1,-8.6,\n"},
+          {"stop_times.txt", "T,08:00:00,08:00:00,L1,1\nT,08:10:00,08:10:00,L2,2\n"}}));
+  Raptor unknown_raptor(parser.getFeed(), DEFAULT_MAX_WALKING_DURATION);
+
+  for (const auto &[source, target]: {std::pair<std::string, std::string>{"X", "L2"}, {"L1", "X"}}) {
+    Query query = {source, target, {2024, 10, 15, 2}, {7, 0, 0}};
+    query.latest_departure_time = Time{8, 0, 0};
+    unknown_raptor.setQuery(query);
+    ASSERT_THROW(unknown_raptor.findJourneys(), std::runtime_error);
+    ASSERT_THROW(unknown_raptor.findProfileJourneys(), std::runtime_error);
+    ASSERT_THROW(unknown_raptor.findMultiCriteriaJourneys(), std::runtime_error);
+  }
+
+  unknown_raptor.setQuery({"X", "", {2024, 10, 15, 2}, {7, 0, 0}});
+  ASSERT_THROW(unknown_raptor.findAllArrivals(), std::runtime_error);
+
+  // One-to-all queries ignore the target
+  unknown_raptor.setQuery({"L1", "X", {2024, 10, 15, 2}, {7, 0, 0}});
+  ASSERT_EQ(unknown_raptor.findAllArrivals().back()[1], Utils::timeToSeconds("08:10:00"));
+}
+
+/**
+ * @test OvertakingTrip
+ * @brief Tests that a trip overtaking another of the same stops gets its own route, and is taken.
+ */
+TEST(OvertakingTripTests, TakesExpressLeavingLater) {
+  Parser parser(writeFeed("overtaking", {
+          {"routes.txt", "R,A\n"},
+          {"trips.txt", "R,S,SLOW\nR,S,EXPRESS\n"},
+          {"stops.txt", "L1,One,41.0,-8.6,\nL2,Two,41.1,-8.6,\nL3,Three,41.2,-8.6,\n"},
+          {"stop_times.txt", "SLOW,08:00:00,08:00:00,L1,1\nSLOW,08:30:00,08:30:00,L2,2\n"
+                             "SLOW,09:00:00,09:00:00,L3,3\nEXPRESS,08:05:00,08:05:00,L1,1\n"
+                             "EXPRESS,08:15:00,08:15:00,L2,2\nEXPRESS,08:25:00,08:25:00,L3,3\n"}}));
+  Raptor overtaking_raptor(parser.getFeed(), DEFAULT_MAX_WALKING_DURATION);
+
+  // The express overtakes the slow trip, so they are split into two routes
+  ASSERT_EQ(overtaking_raptor.getTimetable().numRoutes(), 2);
+
+  overtaking_raptor.setQuery({"L1", "L3", {2024, 10, 15, 2}, {7, 55, 0}});
+  std::vector<Journey> journeys = overtaking_raptor.findJourneys();
+
+  ASSERT_EQ(journeys.size(), 1);
+  ASSERT_EQ(journeys[0].steps.size(), 1);
+  ASSERT_EQ(overtaking_raptor.getTimetable().getTripId(journeys[0].steps[0].trip_id), "EXPRESS");
+  ASSERT_EQ(journeys[0].arrival_secs, Utils::timeToSeconds("08:25:00"));
+}
+
+/**
+ * @test CalendarDates
+ * @brief Tests that the exceptions of calendar_dates.txt add and remove services on their dates.
+ */
+TEST(CalendarDateTests, AppliesExceptions) {
+  // 15/10/2024 is a holiday: the weekday service is replaced by a service only defined by its exceptions
+  Parser parser(writeFeed("calendar_dates", {
+          {"calendar.txt", "WEEKDAYS,1,1,1,1,1,0,0,20240101,20241231\n"},
+          {"calendar_dates.txt", "WEEKDAYS,20241015,2\nHOLIDAY,20241015,1\n"},
+          {"routes.txt", "R,A\n"},
+          {"trips.txt", "R,WEEKDAYS,W\nR,HOLIDAY,H\n"},
+          {"stops.txt", "L1,One,41.0,-8.6,\nL2,Two,41.1,-8.6,\n"},
+          {"stop_times.txt", "W,08:00:00,08:00:00,L1,1\nW,08:10:00,08:10:00,L2,2\n"
+                             "H,09:00:00,09:00:00,L1,1\nH,09:10:00,09:10:00,L2,2\n"}}));
+  Raptor calendar_raptor(parser.getFeed(), DEFAULT_MAX_WALKING_DURATION);
+
+  calendar_raptor.setQuery({"L1", "L2", {2024, 10, 15, 2}, {7, 0, 0}});
+  std::vector<Journey> journeys = calendar_raptor.findJourneys();
+  ASSERT_EQ(journeys.size(), 1);
+  ASSERT_EQ(calendar_raptor.getTimetable().getTripId(journeys[0].steps[0].trip_id), "H");
+
+  calendar_raptor.setQuery({"L1", "L2", {2024, 10, 16, 3}, {7, 0, 0}});
+  journeys = calendar_raptor.findJourneys();
+  ASSERT_EQ(journeys.size(), 1);
+  ASSERT_EQ(calendar_raptor.getTimetable().getTripId(journeys[0].steps[0].trip_id), "W");
+
+  // The weekday of the next day is kept across months and years
+  Date next = Utils::addOneDay({2024, 12, 31, 2});
+  ASSERT_EQ(next.year, 2025);
+  ASSERT_EQ(next.month, 1);
+  ASSERT_EQ(next.day, 1);
+  ASSERT_EQ(next.weekday, 3);
+}
+
+/**
+ * @test ServiceDays
+ * @brief Tests that trips past midnight run on the next day, and that later days are searched up to the horizon.
+ */
+TEST(ServiceDayTests, TakesOvernightTripsAndLaterDays) {
+  Parser parser(writeFeed("service_days", {
+          {"calendar.txt", "SATURDAY,0,0,0,0,0,1,0,20240101,20241231\nTUESDAY,0,1,0,0,0,0,0,20240101,20241231\n"},
+          {"routes.txt", "R,A\n"},
+          {"trips.txt", "R,SATURDAY,NIGHT\nR,TUESDAY,MORNING\n"},
+          {"stops.txt", "L1,One,41.0,-8.6,\nL2,Two,41.1,-8.6,\n"},
+          {"stop_times.txt", "NIGHT,24:30:00,24:30:00,L1,1\nNIGHT,24:50:00,24:50:00,L2,2\n"
+                             "MORNING,08:00:00,08:00:00,L1,1\nMORNING,08:20:00,08:20:00,L2,2\n"}}));
+  Raptor service_day_raptor(parser.getFeed(), DEFAULT_MAX_WALKING_DURATION);
+
+  // The Saturday night trip still runs after midnight on Sunday
+  service_day_raptor.setQuery({"L1", "L2", {2024, 10, 20, 0}, {0, 10, 0}});
+  std::vector<Journey> journeys = service_day_raptor.findJourneys();
+  ASSERT_EQ(journeys.size(), 1);
+  ASSERT_EQ(service_day_raptor.getTimetable().getTripId(journeys[0].steps[0].trip_id), "NIGHT");
+  ASSERT_EQ(journeys[0].departure_secs, Utils::timeToSeconds("00:30:00"));
+  ASSERT_EQ(journeys[0].arrival_secs, Utils::timeToSeconds("00:50:00"));
+
+  // The Tuesday trip is two days after Sunday night, beyond the default horizon
+  Query query = {"L1", "L2", {2024, 10, 20, 0}, {23, 0, 0}};
+  service_day_raptor.setQuery(query);
+  ASSERT_TRUE(service_day_raptor.findJourneys().empty());
+
+  query.horizon_days = 3;
+  service_day_raptor.setQuery(query);
+  journeys = service_day_raptor.findJourneys();
+  ASSERT_EQ(journeys.size(), 1);
+  ASSERT_EQ(journeys[0].departure_secs, 2 * MIDNIGHT + Utils::timeToSeconds("08:00:00"));
+  ASSERT_EQ(journeys[0].arrival_day, static_cast<Day>(2));
+}
+
+/**
+ * @test Transfers
+ * @brief Tests that the change times and forbidden transfers of transfers.txt are applied.
+ */
+TEST(TransferTests, AppliesChangeTimesAndForbiddenTransfers) {
+  // L4 is next to L2, but the transfer between them is not possible. L6 is far from L5, but next to L7
+  Parser parser(writeFeed("transfers", {
+          {"routes.txt", "R1,A\nR2,A\nR3,A\nR4,A\n"},
+          {"trips.txt", "R1,S,IN\nR2,S,FIRST\nR2,S,SECOND\nR3,S,OTHER\nR4,S,ONWARD\n"},
+          {"stops.txt", "L1,One,41.0,-8.6,\nL2,Two,41.1,-8.6,\nL3,Three,41.2,-8.6,\nL4,Four,41.1001,-8.6,\n"
+                        "L5,Five,41.3,-8.6,\nL6,Six,41.3,-8.7,\nL7,Seven,41.3001,-8.7,\nL8,Eight,41.4,-8.7,\n"},
+          {"transfers.txt", "L2,L2,2,300\nL2,L4,3,\nL5,L6,1,\n"},
+          {"stop_times.txt", "IN,08:00:00,08:00:00,L1,1\nIN,08:10:00,08:10:00,L2,2\n"
+                             "FIRST,08:12:00,08:12:00,L2,1\nFIRST,08:22:00,08:22:00,L3,2\n"
+                             "SECOND,08:20:00,08:20:00,L2,1\nSECOND,08:30:00,08:30:00,L3,2\n"
+                             "OTHER,08:15:00,08:15:00,L4,1\nOTHER,08:25:00,08:25:00,L5,2\n"
+                             "ONWARD,08:30:00,08:30:00,L7,1\nONWARD,08:40:00,08:40:00,L8,2\n"}}));
+  Raptor transfer_raptor(parser.getFeed(), DEFAULT_MAX_WALKING_DURATION);
+
+  // Changing at L2 takes 5 minutes, so the first connection is missed
+  transfer_raptor.setQuery({"L1", "L3", {2024, 10, 15, 2}, {7, 55, 0}});
+  std::vector<Journey> journeys = transfer_raptor.findJourneys();
+  ASSERT_EQ(journeys.size(), 1);
+  ASSERT_EQ(journeys[0].steps.size(), 2);
+  ASSERT_EQ(transfer_raptor.getTimetable().getTripId(journeys[0].steps[1].trip_id), "SECOND");
+
+  // The change time does not apply when boarding at the source
+  transfer_raptor.setQuery({"L2", "L3", {2024, 10, 15, 2}, {8, 10, 0}});
+  journeys = transfer_raptor.findJourneys();
+  ASSERT_EQ(journeys.size(), 1);
+  ASSERT_EQ(transfer_raptor.getTimetable().getTripId(journeys[0].steps[0].trip_id), "FIRST");
+
+  transfer_raptor.setQuery({"L1", "L5", {2024, 10, 15, 2}, {7, 55, 0}});
+  ASSERT_TRUE(transfer_raptor.findJourneys().empty());
+
+  // The timed transfer to L6 is followed by the walk to L7, as a single footpath
+  transfer_raptor.setQuery({"L4", "L8", {2024, 10, 15, 2}, {8, 10, 0}});
+  journeys = transfer_raptor.findJourneys();
+  ASSERT_EQ(journeys.size(), 1);
+  ASSERT_EQ(journeys[0].steps.size(), 3);
+  ASSERT_EQ(journeys[0].steps[1].src_stop, transfer_raptor.getTimetable().findStop("L5"));
+  ASSERT_EQ(journeys[0].steps[1].dest_stop, transfer_raptor.getTimetable().findStop("L7"));
+  ASSERT_EQ(journeys[0].arrival_secs, Utils::timeToSeconds("08:40:00"));
+}
+
+/**
+ * @test MultiCriteria
+ * @brief Tests that multi-criteria queries keep later journeys that walk less, change agency less or cross fewer zones.
+ */
+TEST(MultiCriteriaTests, KeepsJourneysWalkingLessOrChangingAgenciesLess) {
+  // L4 is next to L2, and L6 is in another fare zone
+  Parser parser(writeFeed("criteria", {
+          {"agency.txt", "A,Metro\nB,Bus\n"},
+          {"routes.txt", "R1,A\nR2,A\nR3,B\n"},
+          {"trips.txt", "R1,S,IN\nR2,S,SAME\nR3,S,OTHER\n"},
+          {"stops.txt", "L1,One,41.0,-8.6,Z1\nL2,Two,41.1,-8.6,Z1\nL3,Three,41.2,-8.6,Z1\nL4,Four,41.1001,-8.6,Z1\n"
+                        "L6,Six,41.3,-8.6,Z2\n"},
+          {"stop_times.txt", "IN,08:00:00,08:00:00,L1,1\nIN,08:10:00,08:10:00,L2,2\n"
+                             "SAME,08:20:00,08:20:00,L2,1\nSAME,08:35:00,08:35:00,L3,2\n"
+                             "OTHER,08:15:00,08:15:00,L4,1\nOTHER,08:20:00,08:20:00,L6,2\n"
+                             "OTHER,08:25:00,08:25:00,L3,3\n"}}));
+  Raptor criteria_raptor(parser.getFeed(), DEFAULT_MAX_WALKING_DURATION);
+
+  // Without extra criteria, only the earliest arrival is kept
+  Query query = {"L1", "L3", {2024, 10, 15, 2}, {7, 55, 0}};
+  criteria_raptor.setQuery(query);
+  std::vector<Journey> journeys = criteria_raptor.findMultiCriteriaJourneys();
+  ASSERT_EQ(journeys.size(), 1);
+  ASSERT_EQ(journeys[0].steps.size(), 3);
+  ASSERT_EQ(criteria_raptor.getTimetable().getTripId(journeys[0].steps[2].trip_id), "OTHER");
+
+  // Staying on the same agency, without walking nor leaving the zone, arrives later
+  for (Criterion criterion: {Criterion::WalkingTime, Criterion::AgencyChanges, Criterion::FareZones}) {
+    query.criteria = {criterion};
+    criteria_raptor.setQuery(query);
+    journeys = criteria_raptor.findMultiCriteriaJourneys();
+    ASSERT_EQ(journeys.size(), 2);
+    ASSERT_EQ(journeys[0].arrival_secs, 8 * 3600 + 25 * 60);
+    ASSERT_EQ(journeys[1].steps.size(), 2);
+    ASSERT_EQ(criteria_raptor.getTimetable().getTripId(journeys[1].steps[1].trip_id), "SAME");
+  }
+}
+
+/**
+ * @test SnapshotChecksum
+ * @brief Tests that loading a snapshot only checks its header, and that verifying it checks every byte.
+ */
+TEST(SnapshotTests, VerifiesChecksumOnlyOnRequest) {
+  Parser parser(writeFeed("snapshot", {
+          {"routes.txt", "R,A\n"},
+          {"trips.txt", "R,S,T\n"},
+          {"stops.txt", "L1,One,41.0,-8.6,\nL2,Two,41.1,-8.6,\n"},
+          {"stop_times.txt", "T,08:00:00,08:00:00,L1,1\nT,08:10:00,08:10:00,L2,2\n"}}));
+  std::string path = testing::TempDir() + "snapshot.bin";
+  Raptor(parser.getFeed(), DEFAULT_MAX_WALKING_DURATION).getTimetable().save(path);
+
+  Timetable::load(path).verify();
+
+  // Flip a bit of the last column
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekg(-1, std::ios::end);
+    char last = static_cast<char>(file.get());
+    file.seekp(-1, std::ios::end);
+    file.put(static_cast<char>(last ^ 1));
+  }
+
+  Timetable timetable = Timetable::load(path);
+  ASSERT_EQ(timetable.numStops(), 2);
+  ASSERT_THROW(timetable.verify(), std::runtime_error);
+}
+
+/**
+ * @struct PointTraits
+ * @brief Points compared by both coordinates, sorted by the first.
+ */
+struct PointTraits {
+  static int key(const std::pair<int, int> &point) { return point.first; }
+  static bool dominates(const std::pair<int, int> &point1, const std::pair<int, int> &point2) {
+    return point1.first <= point2.first && point1.second <= point2.second;
+  }
+  static constexpr bool SKYLINE = true;
+};
+
+/**
+ * @test ParetoSet
+ * @brief Tests that a Pareto set only keeps the elements no other element dominates, sorted by key.
+ */
+TEST(ParetoSetTests, KeepsSkylineSortedByKey) {
+  ParetoSet<std::pair<int, int>, PointTraits> points;
+
+  ASSERT_TRUE(points.insert({5, 5}));
+  ASSERT_TRUE(points.insert({1, 9}));
+  ASSERT_TRUE(points.insert({9, 1}));
+  ASSERT_FALSE(points.insert({6, 6}));
+  ASSERT_FALSE(points.insert({5, 5}));
+
+  // Dominates both (5, 5) and (9, 1)
+  ASSERT_TRUE(points.insert({4, 1}));
+  ASSERT_TRUE(points.isDominated({7, 2}));
+  ASSERT_FALSE(points.isDominated({0, 10}));
+
+  std::vector<std::pair<int, int>> expected = {{1, 9}, {4, 1}};
+  ASSERT_EQ(points.release(), expected);
+  ASSERT_TRUE(points.empty());
+}